@@ -22,11 +22,14 @@ interface WebSocketControllerState<D> {
   connected: boolean;
   clientId?: string;
   data?: D;
+  revision?: number;
 }
 
 enum WebSocketMessageType {
   ID = "id",
-  PAYLOAD = "payload"
+  PAYLOAD = "payload",
+  PATCH = "patch",
+  RESYNC = "resync"
 }
 
 interface WebSocketIdMessage {
@@ -37,10 +40,37 @@ interface WebSocketIdMessage {
 interface WebSocketPayloadMessage<D> {
   type: typeof WebSocketMessageType.PAYLOAD;
   origin_id: string;
+  revision: number;
   payload: D;
 }
 
-export type WebSocketMessage<D> = WebSocketIdMessage | WebSocketPayloadMessage<D>;
+interface WebSocketPatchMessage<D> {
+  type: typeof WebSocketMessageType.PATCH;
+  origin_id: string;
+  revision: number;
+  base: number;
+  payload: Partial<D>;
+}
+
+export type WebSocketMessage<D> = WebSocketIdMessage | WebSocketPayloadMessage<D> | WebSocketPatchMessage<D>;
+
+const isObject = (value: any) => typeof value === 'object' && value !== null && !Array.isArray(value);
+
+// applies a JSON merge patch (RFC 7386), members set to null are removed
+function mergePatch(target: any, patch: any): any {
+  const result = { ...target };
+  Object.keys(patch).forEach((key) => {
+    const value = patch[key];
+    if (value === null) {
+      delete result[key];
+    } else if (isObject(value)) {
+      result[key] = mergePatch(isObject(result[key]) ? result[key] : {}, value);
+    } else {
+      result[key] = value;
+    }
+  });
+  return result;
+}
 
 export function webSocketController<D, P extends WebSocketControllerProps<D>>(wsUrl: string, wsThrottle: number, WebSocketController: React.ComponentType<P & WebSocketControllerProps<D>>) {
   return withSnackbar(
@@ -73,14 +103,35 @@ export function webSocketController<D, P extends WebSocketControllerProps<D>>(ws
           case WebSocketMessageType.ID:
             this.setState({ clientId: message.id });
             break;
-          case WebSocketMessageType.PAYLOAD:
+          case WebSocketMessageType.PAYLOAD: {
             const { clientId, data } = this.state;
             if (clientId && (!data || clientId !== message.origin_id)) {
               this.setState(
-                { data: message.payload }
+                { data: message.payload, revision: message.revision }
+              );
+            } else {
+              this.setState({ revision: message.revision });
+            }
+            break;
+          }
+          case WebSocketMessageType.PATCH: {
+            // patches only carry the changes, so they can only be applied on top of the revision they were made from
+            const { clientId, data, revision, ws } = this.state;
+            if (!clientId || !data || revision === undefined) {
+              break;
+            }
+            if (message.base !== revision) {
+              // a broadcast was missed, ask once for the full state
+              this.setState({ revision: undefined }, () => ws.json({ type: WebSocketMessageType.RESYNC }));
+            } else if (clientId !== message.origin_id) {
+              this.setState(
+                { data: mergePatch(data, message.payload), revision: message.revision }
               );
+            } else {
+              this.setState({ revision: message.revision });
             }
             break;
+          }
         }
       }
 
@@ -89,7 +140,7 @@ export function webSocketController<D, P extends WebSocketControllerProps<D>>(ws
       }
 
       onClose = () => {
-        this.setState({ connected: false, clientId: undefined, data: undefined });
+        this.setState({ connected: false, clientId: undefined, data: undefined, revision: undefined });
       }
 
       setData = (data: D, callback?: () => void) => {
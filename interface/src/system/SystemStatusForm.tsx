@@ -85,6 +85,42 @@ class SystemStatusForm extends Component<SystemStatusFormProps, SystemStatusForm
             </Fragment>)
         }
         <Divider variant="inset" component="li" />
+        <ListItem >
+          <ListItemAvatar>
+            <Avatar>
+              <MemoryIcon />
+            </Avatar>
+          </ListItemAvatar>
+          <ListItemText primary="JSON Pool (Hits / Misses)" secondary={formatNumber(data.json_pool_hits) + ' / ' + formatNumber(data.json_pool_misses)} />
+        </ListItem>
+        <Divider variant="inset" component="li" />
+        <ListItem >
+          <ListItemAvatar>
+            <Avatar>
+              <MemoryIcon />
+            </Avatar>
+          </ListItemAvatar>
+          <ListItemText primary="Requests Shed (Background / Normal)" secondary={formatNumber(data.requests_shed_background) + ' / ' + formatNumber(data.requests_shed_normal)} />
+        </ListItem>
+        <Divider variant="inset" component="li" />
+        <ListItem >
+          <ListItemAvatar>
+            <Avatar>
+              <MemoryIcon />
+            </Avatar>
+          </ListItemAvatar>
+          <ListItemText primary="Propagation Latency (Mean / Max)" secondary={formatNumber(data.propagation_latency_mean) + ' / ' + formatNumber(data.propagation_latency_max) + ' ms'} />
+        </ListItem>
+        <Divider variant="inset" component="li" />
+        <ListItem >
+          <ListItemAvatar>
+            <Avatar>
+              <MemoryIcon />
+            </Avatar>
+          </ListItemAvatar>
+          <ListItemText primary="Update Handlers Refused" secondary={formatNumber(data.update_handlers_refused)} />
+        </ListItem>
+        <Divider variant="inset" component="li" />
         <ListItem >
           <ListItemAvatar>
             <Avatar>
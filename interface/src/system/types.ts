@@ -13,6 +13,13 @@ interface ESPSystemStatus {
   sdk_version: string;
   flash_chip_size: number;
   flash_chip_speed: number;
+  json_pool_hits: number;
+  json_pool_misses: number;
+  requests_shed_background: number;
+  requests_shed_normal: number;
+  propagation_latency_mean: number;
+  propagation_latency_max: number;
+  update_handlers_refused: number;
   fs_used: number;
   fs_total: number;
 }
@@ -6,7 +6,12 @@ APSettingsService::APSettingsService(AsyncWebServer* server, FS* fs, SecurityMan
     _dnsServer(nullptr),
     _lastManaged(0),
     _reconfigureAp(false) {
-  addUpdateHandler([&](const String& originId) { reconfigureAP(); }, false);
+  addUpdateHandler(
+      [](void* context, const String& originId, state_field_mask_t changedFields) {
+        static_cast<APSettingsService*>(context)->reconfigureAP();
+      },
+      this,
+      false);
 }
 
 void APSettingsService::begin() {
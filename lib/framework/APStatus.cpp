@@ -4,19 +4,25 @@ APStatus::APStatus(AsyncWebServer* server, SecurityManager* securityManager, APS
     _apSettingsService(apSettingsService) {
   server->on(AP_STATUS_SERVICE_PATH,
              HTTP_GET,
-             securityManager->wrapRequest(std::bind(&APStatus::apStatus, this, std::placeholders::_1),
-                                          AuthenticationPredicates::IS_AUTHENTICATED));
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&APStatus::apStatus, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_AUTHENTICATED),
+                 RequestPriority::BACKGROUND,
+                 MAX_AP_STATUS_SIZE));
 }
 
 void APStatus::apStatus(AsyncWebServerRequest* request) {
   AsyncJsonResponse* response = new AsyncJsonResponse(false, MAX_AP_STATUS_SIZE);
   JsonObject root = response->getRoot();
+  read(this, root);
+  response->setLength();
+  request->send(response);
+}
 
-  root["status"] = _apSettingsService->getAPNetworkStatus();
+void APStatus::read(void* context, JsonObject& root) {
+  APStatus* status = static_cast<APStatus*>(context);
+  root["status"] = status->_apSettingsService->getAPNetworkStatus();
   root["ip_address"] = WiFi.softAPIP().toString();
   root["mac_address"] = WiFi.softAPmacAddress();
   root["station_num"] = WiFi.softAPgetStationNum();
-
-  response->setLength();
-  request->send(response);
 }
@@ -9,6 +9,7 @@
 #include <ESPAsyncTCP.h>
 #endif
 
+#include <AdmissionControl.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
@@ -23,6 +24,9 @@ class APStatus {
  public:
   APStatus(AsyncWebServer* server, SecurityManager* securityManager, APSettingsService* apSettingsService);
 
+  // writes the status to root, also used to serve the status from the batch endpoint
+  static void read(void* context, JsonObject& root);
+
  private:
   APSettingsService* _apSettingsService;
   void apStatus(AsyncWebServerRequest* request);
@@ -0,0 +1,143 @@
+#include <AdmissionControl.h>
+
+#ifdef ESP32
+static portMUX_TYPE admissionMux = portMUX_INITIALIZER_UNLOCKED;
+#define ADMISSION_LOCK() portENTER_CRITICAL(&admissionMux)
+#define ADMISSION_UNLOCK() portEXIT_CRITICAL(&admissionMux)
+#else
+#define ADMISSION_LOCK()
+#define ADMISSION_UNLOCK()
+#endif
+
+AdmissionControl::Hold AdmissionControl::_holds[ADMISSION_CONTROL_MAX_HOLDS];
+uint8_t AdmissionControl::_holdCount = 0;
+uint32_t AdmissionControl::_reserved = 0;
+uint32_t AdmissionControl::_shed[(uint8_t)RequestPriority::CONTROL] = {0};
+
+bool AdmissionControl::admit(RequestPriority priority, size_t reserve) {
+  // the heap is read outside the critical section as the allocator takes its own lock
+  uint32_t freeHeap = ESP.getFreeHeap();
+#ifdef ESP32
+  uint32_t maxFreeBlock = ESP.getMaxAllocHeap();
+#else
+  uint32_t maxFreeBlock = ESP.getMaxFreeBlockSize();
+#endif
+  uint32_t watermark = priority == RequestPriority::BACKGROUND ? ADMISSION_CONTROL_BACKGROUND_WATERMARK
+                                                                : ADMISSION_CONTROL_NORMAL_WATERMARK;
+  ADMISSION_LOCK();
+  bool admitted = priority == RequestPriority::CONTROL ||
+                  (freeHeap >= _reserved + reserve + watermark && maxFreeBlock >= reserve);
+  if (admitted) {
+    _reserved += reserve;
+  } else {
+    _shed[(uint8_t)priority]++;
+  }
+  ADMISSION_UNLOCK();
+  return admitted;
+}
+
+void AdmissionControl::release(size_t reserve) {
+  ADMISSION_LOCK();
+  _reserved -= reserve;
+  ADMISSION_UNLOCK();
+}
+
+bool AdmissionControl::admitRequest(AsyncWebServerRequest* request, RequestPriority priority, size_t reserve) {
+  if (admit(priority, reserve)) {
+    return true;
+  }
+  AsyncWebServerResponse* response = request->beginResponse(ADMISSION_CONTROL_SERVICE_UNAVAILABLE);
+  response->addHeader("Retry-After", String(ADMISSION_CONTROL_RETRY_AFTER));
+  request->send(response);
+  return false;
+}
+
+bool AdmissionControl::hold(AsyncWebServerRequest* request, size_t reserve) {
+  // holding the request again would replace the disconnect handler releasing the first reservation
+  for (uint8_t i = 0; i < _holdCount; i++) {
+    if (_holds[i].request == request) {
+      _holds[i].reserve += reserve;
+      return true;
+    }
+  }
+  if (_holdCount == ADMISSION_CONTROL_MAX_HOLDS) {
+    return false;
+  }
+  _holds[_holdCount++] = {request, reserve, nullptr};
+  request->onDisconnect([request]() { disconnected(request); });
+  return true;
+}
+
+void AdmissionControl::onDisconnect(AsyncWebServerRequest* request, ArDisconnectHandler fn) {
+  for (uint8_t i = 0; i < _holdCount; i++) {
+    if (_holds[i].request == request) {
+      _holds[i].onDisconnect = fn;
+      return;
+    }
+  }
+  request->onDisconnect(fn);
+}
+
+void AdmissionControl::disconnected(AsyncWebServerRequest* request) {
+  for (uint8_t i = 0; i < _holdCount; i++) {
+    if (_holds[i].request == request) {
+      size_t reserve = _holds[i].reserve;
+      ArDisconnectHandler onDisconnect = _holds[i].onDisconnect;
+      _holds[i] = _holds[--_holdCount];
+      _holds[_holdCount].onDisconnect = nullptr;
+      release(reserve);
+      if (onDisconnect) {
+        onDisconnect();
+      }
+      return;
+    }
+  }
+}
+
+void AdmissionControl::serve(AsyncWebServerRequest* request,
+                             size_t reserve,
+                             const ArRequestHandlerFunction& onRequest) {
+  bool held = hold(request, reserve);
+  onRequest(request);
+  if (!held) {
+    release(reserve);
+  }
+}
+
+ArRequestHandlerFunction AdmissionControl::wrapRequest(ArRequestHandlerFunction onRequest,
+                                                       RequestPriority priority,
+                                                       size_t reserve) {
+  return [onRequest, priority, reserve](AsyncWebServerRequest* request) {
+    if (admitRequest(request, priority, reserve)) {
+      serve(request, reserve, onRequest);
+    }
+  };
+}
+
+ArRequestHandlerFunction AdmissionControl::wrapRequest(ArRequestHandlerFunction onRequest,
+                                                       const AdmissionPolicy* policy) {
+  return [onRequest, policy](AsyncWebServerRequest* request) {
+    size_t reserve = policy->reserve;
+    if (admitRequest(request, policy->priority, reserve)) {
+      serve(request, reserve, onRequest);
+    }
+  };
+}
+
+ArJsonRequestHandlerFunction AdmissionControl::wrapCallback(ArJsonRequestHandlerFunction onRequest,
+                                                            const AdmissionPolicy* policy) {
+  return [onRequest, policy](AsyncWebServerRequest* request, JsonVariant& json) {
+    size_t reserve = policy->reserve;
+    if (admitRequest(request, policy->priority, reserve)) {
+      bool held = hold(request, reserve);
+      onRequest(request, json);
+      if (!held) {
+        release(reserve);
+      }
+    }
+  };
+}
+
+uint32_t AdmissionControl::getShed(RequestPriority priority) {
+  return priority == RequestPriority::CONTROL ? 0 : _shed[(uint8_t)priority];
+}
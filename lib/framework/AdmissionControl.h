@@ -0,0 +1,110 @@
+#ifndef AdmissionControl_h
+#define AdmissionControl_h
+
+#include <Arduino.h>
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+
+// background requests are shed once the free heap, less the memory reserved by requests in flight, is below this
+#ifndef ADMISSION_CONTROL_BACKGROUND_WATERMARK
+#define ADMISSION_CONTROL_BACKGROUND_WATERMARK 16384
+#endif
+
+#ifndef ADMISSION_CONTROL_NORMAL_WATERMARK
+#define ADMISSION_CONTROL_NORMAL_WATERMARK 8192
+#endif
+
+// seconds shed clients are asked to wait before retrying
+#ifndef ADMISSION_CONTROL_RETRY_AFTER
+#define ADMISSION_CONTROL_RETRY_AFTER 2
+#endif
+
+// requests whose reservation is held until they disconnect, further requests release theirs when their handler returns
+#ifndef ADMISSION_CONTROL_MAX_HOLDS
+#define ADMISSION_CONTROL_MAX_HOLDS 8
+#endif
+
+#define ADMISSION_CONTROL_SERVICE_UNAVAILABLE 503
+
+enum class RequestPriority : uint8_t {
+  // status polls and scans, which the client will simply repeat
+  BACKGROUND = 0,
+  // reading and changing settings
+  NORMAL = 1,
+  // commands which must get through, never shed
+  CONTROL = 2
+};
+
+struct AdmissionPolicy {
+  RequestPriority priority;
+  // the memory the request needs to be served, usually the capacity of its JSON document
+  size_t reserve;
+};
+
+/**
+ * Sheds requests when the heap is low, before they allocate their JSON documents and responses, rather than letting a
+ * burst of requests exhaust the heap. Requests of each priority below CONTROL are admitted while the free heap, less
+ * the memory reserved for requests being served, stays above the priority's watermark and the largest free block can
+ * hold the request's reserve. Shed requests are answered with 503 and a Retry-After header and counted.
+ *
+ * A request's reserve is held until the request disconnects, as chunked responses, held long-polls and queued sends
+ * keep their memory after the handler has returned. The request's single disconnect handler is taken to release it, so
+ * handlers of admitted requests register theirs through AdmissionControl::onDisconnect().
+ *
+ * The wrappers are applied outside SecurityManager's, so a shed request is answered before its JWT is verified rather
+ * than paying for the verification first. A shed request gets 503 even if it would have been refused with 401.
+ */
+class AdmissionControl {
+ public:
+  static bool admit(RequestPriority priority, size_t reserve);
+  static void release(size_t reserve);
+
+  // admits the request, or answers it with 503 if it is shed
+  static bool admitRequest(AsyncWebServerRequest* request, RequestPriority priority, size_t reserve);
+
+  /**
+   * Holds the reservation of an admitted request until it disconnects. Returns false if ADMISSION_CONTROL_MAX_HOLDS
+   * requests are already held, the caller then releases the reservation once its handler returns. A request held again
+   * has the reservation added to the one it holds.
+   *
+   * The hold takes the request's disconnect handler, a handler set with request->onDisconnect() afterwards replaces it
+   * and the reservation is never released. Handlers which may run under a hold use AdmissionControl::onDisconnect().
+   */
+  static bool hold(AsyncWebServerRequest* request, size_t reserve);
+
+  // calls fn when the request disconnects, after any reservation it holds has been released
+  static void onDisconnect(AsyncWebServerRequest* request, ArDisconnectHandler fn);
+
+  static ArRequestHandlerFunction wrapRequest(ArRequestHandlerFunction onRequest,
+                                              RequestPriority priority,
+                                              size_t reserve);
+
+  // the policy is read as each request arrives, so it may be changed after the handler has been registered
+  static ArRequestHandlerFunction wrapRequest(ArRequestHandlerFunction onRequest, const AdmissionPolicy* policy);
+  static ArJsonRequestHandlerFunction wrapCallback(ArJsonRequestHandlerFunction onRequest,
+                                                   const AdmissionPolicy* policy);
+
+  static uint32_t getShed(RequestPriority priority);
+
+  static uint32_t getReserved() {
+    return _reserved;
+  }
+
+ private:
+  // only used from the web server's task, which runs both the handlers and the disconnects
+  struct Hold {
+    AsyncWebServerRequest* request;
+    size_t reserve;
+    ArDisconnectHandler onDisconnect;
+  };
+
+  static Hold _holds[ADMISSION_CONTROL_MAX_HOLDS];
+  static uint8_t _holdCount;
+  static uint32_t _reserved;
+  static uint32_t _shed[(uint8_t)RequestPriority::CONTROL];
+
+  static void serve(AsyncWebServerRequest* request, size_t reserve, const ArRequestHandlerFunction& onRequest);
+  static void disconnected(AsyncWebServerRequest* request);
+};
+
+#endif  // end AdmissionControl_h
@@ -0,0 +1,230 @@
+#include <BatchEndpoint.h>
+
+static_assert(BATCH_ENDPOINT_MAX_SOURCES <= 32, "Written sources are tracked in a 32 bit mask");
+
+BatchEndpoint::BatchEndpoint(AsyncWebServer* server, SecurityManager* securityManager) :
+    _securityManager(securityManager),
+    _writeAdmission{RequestPriority::NORMAL, BATCH_ENDPOINT_MAX_CONTENT_LENGTH},
+    _writeHandler(BATCH_ENDPOINT_PATH,
+                  AdmissionControl::wrapCallback(
+                      std::bind(&BatchEndpoint::writeSources, this, std::placeholders::_1, std::placeholders::_2),
+                      &_writeAdmission),
+                  BATCH_ENDPOINT_MAX_CONTENT_LENGTH),
+    _sourceCount(0) {
+  // requests are authenticated once, each source then checks its own predicate
+  server->on(BATCH_ENDPOINT_PATH, HTTP_GET, std::bind(&BatchEndpoint::readSources, this, std::placeholders::_1));
+  _writeHandler.setMethod(HTTP_POST);
+  server->addHandler(&_writeHandler);
+}
+
+BatchEndpoint::~BatchEndpoint() {
+  for (uint8_t i = 0; i < _sourceCount; i++) {
+    if (_sources[i].release) {
+      _sources[i].release(_sources[i].context);
+    }
+  }
+}
+
+bool BatchEndpoint::addReader(const char* name,
+                              BatchReadFunction readFunction,
+                              void* context,
+                              size_t bufferSize,
+                              AuthenticationPredicate readPredicate) {
+  if (_sourceCount == BATCH_ENDPOINT_MAX_SOURCES) {
+    return false;
+  }
+  _sources[_sourceCount++] = {
+      name, readFunction, nullptr, nullptr, nullptr, nullptr, context, bufferSize, readPredicate, nullptr};
+  return true;
+}
+
+void BatchEndpoint::readSources(AsyncWebServerRequest* request) {
+  Authentication authentication = _securityManager->authenticateRequest(request);
+  Source* sources[BATCH_ENDPOINT_MAX_SOURCES];
+  uint8_t count = 0;
+  AsyncWebParameter* include = request->getParam(BATCH_ENDPOINT_INCLUDE_PARAMETER);
+  if (include) {
+    const String& names = include->value();
+    for (int start = 0; start < (int)names.length();) {
+      int end = names.indexOf(',', start);
+      if (end < 0) {
+        end = names.length();
+      }
+      if (end > start) {
+        Source* source = find(names.c_str() + start, end - start);
+        if (!source) {
+          request->send(400);
+          return;
+        }
+        if (!source->readPredicate(authentication)) {
+          request->send(401);
+          return;
+        }
+        bool included = false;
+        for (uint8_t i = 0; i < count && !included; i++) {
+          included = sources[i] == source;
+        }
+        if (!included) {
+          sources[count++] = source;
+        }
+      }
+      start = end + 1;
+    }
+  } else {
+    for (uint8_t i = 0; i < _sourceCount; i++) {
+      if (_sources[i].readPredicate(authentication)) {
+        sources[count++] = &_sources[i];
+      }
+    }
+    if (!count && !authentication.authenticated) {
+      request->send(401);
+      return;
+    }
+  }
+  // unlike other endpoints admitted after authentication, as the reserve depends on the sources the client may read
+  size_t capacity = capacityOf(sources, count);
+  if (AdmissionControl::admitRequest(request, RequestPriority::BACKGROUND, capacity)) {
+    bool held = AdmissionControl::hold(request, capacity);
+    sendSources(request, sources, count);
+    if (!held) {
+      AdmissionControl::release(capacity);
+    }
+  }
+}
+
+void BatchEndpoint::writeSources(AsyncWebServerRequest* request, JsonVariant& json) {
+  if (!json.is<JsonObject>()) {
+    request->send(400);
+    return;
+  }
+  Authentication authentication = _securityManager->authenticateRequest(request);
+  JsonObject root = json.as<JsonObject>();
+  Source* sources[BATCH_ENDPOINT_MAX_SOURCES];
+  uint8_t count = 0;
+
+  // nothing is written unless every source accepts its state
+  for (JsonPair member : root) {
+    JsonString name = member.key();
+    Source* source = find(name.c_str(), strlen(name.c_str()));
+    if (!source || !source->write || !member.value().is<JsonObject>() || count == BATCH_ENDPOINT_MAX_SOURCES) {
+      request->send(400);
+      return;
+    }
+    if (!source->writePredicate(authentication)) {
+      request->send(401);
+      return;
+    }
+    JsonObject state = member.value().as<JsonObject>();
+    if (source->validate(source->context, state) == StateUpdateResult::ERROR) {
+      request->send(400);
+      return;
+    }
+    sources[count++] = source;
+  }
+
+  // a service changed since it was checked may still reject its state, the others are written regardless
+  bool rejected = false;
+  uint32_t changed = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    JsonObject state = root[sources[i]->name];
+    StateUpdateResult result = sources[i]->write(sources[i]->context, state);
+    if (result == StateUpdateResult::CHANGED) {
+      changed |= (uint32_t)1 << (sources[i] - _sources);
+    } else if (result == StateUpdateResult::ERROR) {
+      rejected = true;
+    }
+  }
+  // services the queue has no room for propagate when the request disconnects
+  uint32_t unqueued = 0;
+  for (uint8_t i = 0; i < _sourceCount; i++) {
+    if ((changed & ((uint32_t)1 << i)) &&
+        !PropagationQueue::queue(_sources[i].propagate, _sources[i].context, BATCH_ENDPOINT_ORIGIN_ID, request)) {
+      unqueued |= (uint32_t)1 << i;
+    }
+  }
+  if (changed) {
+    AdmissionControl::onDisconnect(request, [this, request, unqueued]() {
+      PropagationQueue::release(request);
+      for (uint8_t i = 0; i < _sourceCount; i++) {
+        if (unqueued & ((uint32_t)1 << i)) {
+          _sources[i].propagate(_sources[i].context, BATCH_ENDPOINT_ORIGIN_ID);
+        }
+      }
+    });
+  }
+  sendSources(request, sources, count, rejected ? 409 : 200);
+}
+
+void BatchEndpoint::sendSources(AsyncWebServerRequest* request, Source** sources, uint8_t count, int code) {
+  std::shared_ptr<SourceStream> stream(new SourceStream(sources, count));
+  // chunks are requested in order, so the index is implied by the stream's position
+  AsyncWebServerResponse* response = request->beginChunkedResponse(
+      JSON_MIMETYPE, [stream](uint8_t* buffer, size_t maxLen, size_t index) { return stream->write(buffer, maxLen); });
+  response->setCode(code);
+  request->send(response);
+}
+
+// sources are read one at a time, so only the largest document is allocated at once
+size_t BatchEndpoint::capacityOf(Source** sources, uint8_t count) {
+  size_t capacity = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (sources[i]->bufferSize > capacity) {
+      capacity = sources[i]->bufferSize;
+    }
+  }
+  return capacity;
+}
+
+BatchEndpoint::SourceStream::SourceStream(Source** sources, uint8_t count) :
+    _count(count), _next(0), _writing(false), _offset(0) {
+  memcpy(_sources, sources, count * sizeof(Source*));
+}
+
+size_t BatchEndpoint::SourceStream::write(uint8_t* buffer, size_t maxLen) {
+  size_t length = 0;
+  while (length < maxLen && _next <= _count) {
+    if (_writing) {
+      length += _writer.write(buffer + length, maxLen - length);
+      if (_writer.done()) {
+        _jsonDocument.reset();
+        _writing = false;
+        _next++;
+      }
+      continue;
+    }
+    // the key of the next source, or the end of the object
+    ChunkPrint window(buffer + length, maxLen - length, _offset);
+    if (_next == _count) {
+      window.print(_count ? "}" : "{}");
+    } else {
+      window.write(_next ? ',' : '{');
+      ChunkedJsonWriter::writeString(window, _sources[_next]->name);
+      window.write(':');
+    }
+    length += window.length();
+    if (!window.complete()) {
+      _offset += window.length();
+      break;
+    }
+    _offset = 0;
+    if (_next == _count) {
+      _next++;
+    } else {
+      _jsonDocument.reset(new PooledJsonDocument(_sources[_next]->bufferSize));
+      JsonObject root = _jsonDocument->to<JsonObject>();
+      _sources[_next]->read(_sources[_next]->context, root);
+      _writer.begin(_jsonDocument.get());
+      _writing = true;
+    }
+  }
+  return length;
+}
+
+BatchEndpoint::Source* BatchEndpoint::find(const char* name, size_t length) {
+  for (uint8_t i = 0; i < _sourceCount; i++) {
+    if (strlen(_sources[i].name) == length && !strncmp(_sources[i].name, name, length)) {
+      return &_sources[i];
+    }
+  }
+  return nullptr;
+}
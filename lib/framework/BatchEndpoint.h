@@ -0,0 +1,183 @@
+#ifndef BatchEndpoint_h
+#define BatchEndpoint_h
+
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+
+#include <AdmissionControl.h>
+#include <ChunkedJsonWriter.h>
+#include <SecurityManager.h>
+#include <StatefulService.h>
+
+#define BATCH_ENDPOINT_PATH "/rest/batch"
+#define BATCH_ENDPOINT_ORIGIN_ID "batch"
+#define BATCH_ENDPOINT_INCLUDE_PARAMETER "include"
+
+#ifndef BATCH_ENDPOINT_MAX_SOURCES
+#define BATCH_ENDPOINT_MAX_SOURCES 16
+#endif
+
+// the largest batch write accepted
+#ifndef BATCH_ENDPOINT_MAX_CONTENT_LENGTH
+#define BATCH_ENDPOINT_MAX_CONTENT_LENGTH 2048
+#endif
+
+typedef void (*BatchReadFunction)(void* context, JsonObject& root);
+typedef StateUpdateResult (*BatchWriteFunction)(void* context, JsonObject& root);
+typedef void (*BatchContextFunction)(void* context);
+
+/**
+ * Serves several services from one request, so a page showing the state of many services needs one connection and one
+ * JWT verification rather than one of each per service.
+ *
+ * Status providers are registered with a read function and StatefulServices with their JSON reader and updater, each
+ * under a name. GET /rest/batch?include=wifiStatus,apStatus responds with an object holding the state of each named
+ * source, or of every source the user may read if include is omitted. POST /rest/batch with an object holding the new
+ * state of one or more services writes them, responding as a GET of the services written.
+ *
+ * A batch write is checked against a copy of each service's state before any service is updated, so if any source is
+ * unknown, forbidden or rejects its state, none are. Past that check writes are best-effort: the services are written
+ * one after another without holding their locks, so a service updated by another task in between may still reject its
+ * state. The other services are written regardless and the request is answered with 409 and the state of every
+ * service named, for the client to resolve. The updates propagate through the PropagationQueue, after all of them have
+ * been applied.
+ *
+ * Reads are admitted as background requests and writes as normal ones. The response is streamed, each source being read
+ * into its own document as the response reaches it and serialized before the next is read, so a read reserves the
+ * capacity of its largest source rather than of every source served. Writes are admitted by the same wrapper as the
+ * other POST endpoints, reserving the larger of their body document, BATCH_ENDPOINT_MAX_CONTENT_LENGTH, and the
+ * capacity of the largest writable source, as both are in use while the request is served.
+ */
+class BatchEndpoint {
+ public:
+  BatchEndpoint(AsyncWebServer* server, SecurityManager* securityManager);
+  ~BatchEndpoint();
+
+  /**
+   * Registers a read only source, such as a status provider, which writes its state to the given object. The buffer
+   * size is the capacity of the JSON document the source needs. Returns false if BATCH_ENDPOINT_MAX_SOURCES sources are
+   * already registered.
+   */
+  bool addReader(const char* name,
+                 BatchReadFunction readFunction,
+                 void* context,
+                 size_t bufferSize,
+                 AuthenticationPredicate readPredicate = AuthenticationPredicates::IS_AUTHENTICATED);
+
+  /**
+   * Registers a StatefulService, read and written with the given reader and updater like an HttpEndpoint.
+   */
+  template <class T>
+  bool addService(const char* name,
+                  StatefulService<T>* statefulService,
+                  typename NonDeduced<JsonStateReader<T>>::type stateReader,
+                  typename NonDeduced<JsonStateUpdater<T>>::type stateUpdater,
+                  AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_ADMIN,
+                  size_t bufferSize = DEFAULT_BUFFER_SIZE) {
+    if (_sourceCount == BATCH_ENDPOINT_MAX_SOURCES) {
+      return false;
+    }
+    ServiceBinding<T>* binding = new ServiceBinding<T>(statefulService, stateReader, stateUpdater);
+    _sources[_sourceCount++] = {name,
+                                ServiceBinding<T>::read,
+                                ServiceBinding<T>::validate,
+                                ServiceBinding<T>::write,
+                                ServiceBinding<T>::propagate,
+                                ServiceBinding<T>::release,
+                                binding,
+                                bufferSize,
+                                authenticationPredicate,
+                                authenticationPredicate};
+    if (bufferSize > _writeAdmission.reserve) {
+      _writeAdmission.reserve = bufferSize;
+    }
+    return true;
+  }
+
+ private:
+  template <class T>
+  class ServiceBinding {
+   public:
+    ServiceBinding(StatefulService<T>* statefulService,
+                   JsonStateReader<T> stateReader,
+                   JsonStateUpdater<T> stateUpdater) :
+        _statefulService(statefulService), _stateReader(stateReader), _stateUpdater(stateUpdater) {
+    }
+
+    static void read(void* context, JsonObject& root) {
+      ServiceBinding* binding = static_cast<ServiceBinding*>(context);
+      binding->_statefulService->read(root, binding->_stateReader);
+    }
+
+    // updates a copy of the state, leaving the service untouched
+    static StateUpdateResult validate(void* context, JsonObject& root) {
+      ServiceBinding* binding = static_cast<ServiceBinding*>(context);
+      T state;
+      binding->_statefulService->read([&](T& current) { state = current; });
+      return binding->_stateUpdater(root, state);
+    }
+
+    static StateUpdateResult write(void* context, JsonObject& root) {
+      ServiceBinding* binding = static_cast<ServiceBinding*>(context);
+      return binding->_statefulService->updateWithoutPropagation(root, binding->_stateUpdater);
+    }
+
+    static void propagate(void* context, const char* originId) {
+      static_cast<ServiceBinding*>(context)->_statefulService->callUpdateHandlers(originId);
+    }
+
+    static void release(void* context) {
+      delete static_cast<ServiceBinding*>(context);
+    }
+
+   private:
+    StatefulService<T>* _statefulService;
+    JsonStateReader<T> _stateReader;
+    JsonStateUpdater<T> _stateUpdater;
+  };
+
+  struct Source {
+    const char* name;
+    BatchReadFunction read;
+    BatchWriteFunction validate;
+    BatchWriteFunction write;
+    PropagationFunction propagate;
+    BatchContextFunction release;
+    void* context;
+    size_t bufferSize;
+    AuthenticationPredicate readPredicate;
+    AuthenticationPredicate writePredicate;
+  };
+
+  // writes the sources' states one after another, as a single object holding each under its name
+  class SourceStream {
+   public:
+    SourceStream(Source** sources, uint8_t count);
+    size_t write(uint8_t* buffer, size_t maxLen);
+
+   private:
+    Source* _sources[BATCH_ENDPOINT_MAX_SOURCES];
+    uint8_t _count;
+    // the source being written, or the next source to read
+    uint8_t _next;
+    bool _writing;
+    // the number of bytes of the current member key written by previous chunks
+    size_t _offset;
+    std::unique_ptr<PooledJsonDocument> _jsonDocument;
+    ChunkedJsonWriter _writer;
+  };
+
+  SecurityManager* _securityManager;
+  AdmissionPolicy _writeAdmission;
+  AsyncCallbackJsonWebHandler _writeHandler;
+  Source _sources[BATCH_ENDPOINT_MAX_SOURCES];
+  uint8_t _sourceCount;
+
+  void readSources(AsyncWebServerRequest* request);
+  void writeSources(AsyncWebServerRequest* request, JsonVariant& json);
+  void sendSources(AsyncWebServerRequest* request, Source** sources, uint8_t count, int code = 200);
+  static size_t capacityOf(Source** sources, uint8_t count);
+  Source* find(const char* name, size_t length);
+};
+
+#endif  // end BatchEndpoint_h
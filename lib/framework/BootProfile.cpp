@@ -0,0 +1,84 @@
+#include <BootProfile.h>
+#include <JsonDocumentPool.h>
+
+#include <string.h>
+#include <time.h>
+
+#ifdef ESP32
+static portMUX_TYPE profileMux = portMUX_INITIALIZER_UNLOCKED;
+#define PROFILE_LOCK() portENTER_CRITICAL(&profileMux)
+#define PROFILE_UNLOCK() portEXIT_CRITICAL(&profileMux)
+#else
+#define PROFILE_LOCK()
+#define PROFILE_UNLOCK()
+#endif
+
+BootProfile::Event BootProfile::_events[BOOT_PROFILE_MAX_EVENTS];
+uint8_t BootProfile::_eventCount = 0;
+
+BootProfile::BootProfile(AsyncWebServer* server, SecurityManager* securityManager) : _loopHook(markTimeSet, this) {
+  server->on(BOOT_PROFILE_SERVICE_PATH,
+             HTTP_GET,
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&BootProfile::bootProfile, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_AUTHENTICATED),
+                 RequestPriority::BACKGROUND,
+                 MAX_BOOT_PROFILE_SIZE));
+  _loopHook.attach();
+}
+
+void BootProfile::mark(const char* name) {
+  add(name, millis(), 0);
+}
+
+void BootProfile::record(const char* name, uint32_t startedAt) {
+  add(name, startedAt, millis() - startedAt);
+}
+
+void BootProfile::add(const char* name, uint32_t at, uint32_t duration) {
+  PROFILE_LOCK();
+  bool recorded = false;
+  for (uint8_t i = 0; i < _eventCount && !recorded; i++) {
+    recorded = strcmp(_events[i].name, name) == 0;
+  }
+  if (!recorded && _eventCount < BOOT_PROFILE_MAX_EVENTS) {
+    _events[_eventCount].name = name;
+    _events[_eventCount].at = at;
+    _events[_eventCount].duration = duration;
+    _eventCount++;
+  }
+  PROFILE_UNLOCK();
+}
+
+void BootProfile::read(JsonObject& root) {
+  root["uptime"] = millis();
+  JsonArray events = root.createNestedArray("events");
+  PROFILE_LOCK();
+  uint8_t eventCount = _eventCount;
+  PROFILE_UNLOCK();
+  // events are never removed, so those counted may be read without the lock
+  for (uint8_t i = 0; i < eventCount; i++) {
+    JsonObject event = events.createNestedObject();
+    event["name"] = _events[i].name;
+    event["at"] = _events[i].at;
+    if (_events[i].duration) {
+      event["duration"] = _events[i].duration;
+    }
+  }
+}
+
+void BootProfile::markTimeSet(void* context) {
+  if (time(nullptr) > BOOT_PROFILE_TIME_SET) {
+    mark("time_set");
+    static_cast<BootProfile*>(context)->_loopHook.detach();
+  }
+}
+
+void BootProfile::bootProfile(AsyncWebServerRequest* request) {
+  PooledJsonDocument jsonDocument(MAX_BOOT_PROFILE_SIZE);
+  JsonObject root = jsonDocument.to<JsonObject>();
+  read(root);
+  String payload;
+  serializeJson(jsonDocument, payload);
+  request->send(200, JSON_MIMETYPE, payload);
+}
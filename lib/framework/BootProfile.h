@@ -0,0 +1,77 @@
+#ifndef BootProfile_h
+#define BootProfile_h
+
+#ifdef ESP32
+#include <WiFi.h>
+#include <AsyncTCP.h>
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#include <ESPAsyncTCP.h>
+#endif
+
+#include <AdmissionControl.h>
+#include <ArduinoJson.h>
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+#include <LoopHook.h>
+#include <SecurityManager.h>
+
+#ifndef BOOT_PROFILE_MAX_EVENTS
+#define BOOT_PROFILE_MAX_EVENTS 24
+#endif
+
+#define BOOT_PROFILE_SERVICE_PATH "/rest/bootProfile"
+
+// event names are not copied
+#define MAX_BOOT_PROFILE_SIZE \
+  (JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(BOOT_PROFILE_MAX_EVENTS) + BOOT_PROFILE_MAX_EVENTS * JSON_OBJECT_SIZE(3))
+
+// the clock is taken to be set by NTP once it is past 2020-01-01
+#define BOOT_PROFILE_TIME_SET 1577836800
+
+/**
+ * A timeline of the device's boot: how long each service took to load and when milestones such as the WiFi connecting
+ * or the first MQTT connection were reached, in milliseconds since boot. Only the first occurrence of an event is
+ * recorded, so reconnections later on do not overwrite the boot timeline.
+ *
+ * Events may be recorded from any task. The timeline is served at /rest/bootProfile.
+ */
+class BootProfile {
+ public:
+  BootProfile(AsyncWebServer* server, SecurityManager* securityManager);
+
+  // records a milestone reached now
+  static void mark(const char* name);
+
+  // records a step which started at the given time and ended now
+  static void record(const char* name, uint32_t startedAt);
+
+  // runs and records a step
+  template <typename Function>
+  static void measure(const char* name, Function function) {
+    uint32_t startedAt = millis();
+    function();
+    record(name, startedAt);
+  }
+
+  static void read(JsonObject& root);
+
+ private:
+  struct Event {
+    const char* name;
+    uint32_t at;
+    uint32_t duration;
+  };
+
+  static Event _events[BOOT_PROFILE_MAX_EVENTS];
+  static uint8_t _eventCount;
+
+  LoopHook _loopHook;
+
+  static void add(const char* name, uint32_t at, uint32_t duration);
+  static void markTimeSet(void* context);
+
+  void bootProfile(AsyncWebServerRequest* request);
+};
+
+#endif  // end BootProfile_h
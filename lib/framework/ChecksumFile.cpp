@@ -0,0 +1,73 @@
+#include <ChecksumFile.h>
+
+size_t ChecksumPrint::write(const uint8_t* buffer, size_t size) {
+  size_t written = _file ? _file->write(buffer, size) : size;
+  _crc = ChecksumFile::crc32(buffer, written, _crc);
+  return written;
+}
+
+bool ChecksumFile::write(JsonDocument& jsonDocument, File& file, JsonFileFormat format) {
+  ChecksumPrint checksumPrint(file);
+  if (serialize(jsonDocument, checksumPrint, format) != measure(jsonDocument, format)) {
+    return false;
+  }
+  char trailer[CHECKSUM_TRAILER_LENGTH + 1];
+  snprintf(trailer, sizeof(trailer), "\n%08lx", (unsigned long)checksumPrint.crc());
+  return file.write((const uint8_t*)trailer, CHECKSUM_TRAILER_LENGTH) == CHECKSUM_TRAILER_LENGTH;
+}
+
+bool ChecksumFile::verify(File& file) {
+  size_t size = file.size();
+  char trailer[CHECKSUM_TRAILER_LENGTH + 1] = {};
+  if (size < CHECKSUM_TRAILER_LENGTH || !file.seek(size - CHECKSUM_TRAILER_LENGTH) ||
+      file.readBytes(trailer, CHECKSUM_TRAILER_LENGTH) != CHECKSUM_TRAILER_LENGTH || trailer[0] != '\n') {
+    return file.seek(0);
+  }
+  uint32_t crc = 0;
+  uint8_t buffer[64];
+  file.seek(0);
+  for (size_t remaining = size - CHECKSUM_TRAILER_LENGTH; remaining > 0;) {
+    size_t read = file.read(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+    if (!read) {
+      return false;
+    }
+    crc = crc32(buffer, read, crc);
+    remaining -= read;
+  }
+  return strtoul(trailer + 1, nullptr, 16) == crc && file.seek(0);
+}
+
+DeserializationError ChecksumFile::read(JsonDocument& jsonDocument, File& file, JsonFileFormat& format) {
+  int first = file.peek();
+  bool messagePack = (first & 0xf0) == 0x80 || first == 0xde || first == 0xdf;
+  format = messagePack ? JsonFileFormat::MESSAGE_PACK : JsonFileFormat::JSON;
+  return messagePack ? deserializeMsgPack(jsonDocument, file) : deserializeJson(jsonDocument, file);
+}
+
+size_t ChecksumFile::serialize(JsonDocument& jsonDocument, Print& print, JsonFileFormat format) {
+  return format == JsonFileFormat::MESSAGE_PACK ? serializeMsgPack(jsonDocument, print)
+                                                : serializeJson(jsonDocument, print);
+}
+
+size_t ChecksumFile::measure(JsonDocument& jsonDocument, JsonFileFormat format) {
+  return format == JsonFileFormat::MESSAGE_PACK ? measureMsgPack(jsonDocument) : measureJson(jsonDocument);
+}
+
+uint32_t ChecksumFile::checksum(JsonDocument& jsonDocument, JsonFileFormat format) {
+  ChecksumPrint checksumPrint;
+  serialize(jsonDocument, checksumPrint, format);
+  return checksumPrint.crc();
+}
+
+uint32_t ChecksumFile::crc32(const uint8_t* data, size_t length, uint32_t crc) {
+  // half-byte table, a compromise between the bitwise loop and a 1KB table
+  static const uint32_t table[16] = {0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+                                     0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+                                     0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = table[(crc ^ data[i]) & 0x0f] ^ (crc >> 4);
+    crc = table[(crc ^ (data[i] >> 4)) & 0x0f] ^ (crc >> 4);
+  }
+  return ~crc;
+}
@@ -0,0 +1,78 @@
+#ifndef ChecksumFile_h
+#define ChecksumFile_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+
+// a newline followed by the CRC32 of the content as eight hex digits
+#define CHECKSUM_TRAILER_LENGTH 9
+
+enum class JsonFileFormat { JSON, MESSAGE_PACK };
+
+/**
+ * Passes writes on to a file while accumulating their checksum, or only accumulates the checksum if there is no file.
+ */
+class ChecksumPrint : public Print {
+ public:
+  ChecksumPrint() : _file(nullptr), _crc(0) {
+  }
+
+  ChecksumPrint(File& file) : _file(&file), _crc(0) {
+  }
+
+  size_t write(uint8_t c) {
+    return write(&c, 1);
+  }
+
+  size_t write(const uint8_t* buffer, size_t size);
+
+  uint32_t crc() const {
+    return _crc;
+  }
+
+ private:
+  File* _file;
+  uint32_t _crc;
+};
+
+/**
+ * Reads and writes JSON or MessagePack files followed by a CRC32 trailer, so a file cut short by a reset or brown-out
+ * mid-write can be told apart from a good one. The trailer follows the document, which parsers stop reading at the end
+ * of.
+ */
+class ChecksumFile {
+ public:
+  /**
+   * Writes the document followed by its trailer, returning false if it could not all be written. The checksum is
+   * calculated as the document is written, the file is not read back.
+   */
+  static bool write(JsonDocument& jsonDocument, File& file, JsonFileFormat format = JsonFileFormat::JSON);
+
+  /**
+   * Reads the document from the start of the file in whichever format it was written, which is returned in format.
+   * Documents are objects, so the format is told by the first byte: MessagePack maps never start with JSON whitespace
+   * or a brace.
+   */
+  static DeserializationError read(JsonDocument& jsonDocument, File& file, JsonFileFormat& format);
+
+  /**
+   * Returns true if the file's content matches its trailer and rewinds it to the start. Files without a trailer,
+   * written before checksums were added, are accepted and left for the parser to validate.
+   */
+  static bool verify(File& file);
+
+  /**
+   * Writes the document in the given format, returning the number of bytes written, which is short of
+   * measure(jsonDocument, format) if the write failed.
+   */
+  static size_t serialize(JsonDocument& jsonDocument, Print& print, JsonFileFormat format);
+  static size_t measure(JsonDocument& jsonDocument, JsonFileFormat format);
+
+  // the CRC32 of the document as serialize() would write it
+  static uint32_t checksum(JsonDocument& jsonDocument, JsonFileFormat format);
+
+  static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+};
+
+#endif  // end ChecksumFile_h
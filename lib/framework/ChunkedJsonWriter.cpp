@@ -0,0 +1,153 @@
+#include <ChunkedJsonWriter.h>
+
+ChunkedJsonWriter::ChunkedJsonWriter() :
+    _jsonDocument(nullptr), _depth(0), _started(false), _offset(0), _buffer(nullptr), _maxLen(0), _length(0) {
+}
+
+void ChunkedJsonWriter::begin(JsonDocument* jsonDocument) {
+  _jsonDocument = jsonDocument;
+  _depth = 0;
+  _started = false;
+  _offset = 0;
+}
+
+size_t ChunkedJsonWriter::write(uint8_t* buffer, size_t maxLen) {
+  _buffer = buffer;
+  _maxLen = maxLen;
+  _length = 0;
+  // a token which does not fit fills the buffer, ending the loop
+  while (_length < _maxLen && !done()) {
+    step();
+  }
+  return _length;
+}
+
+void ChunkedJsonWriter::writeString(Print& out, const char* value) {
+  out.write('"');
+  for (const char* c = value; *c; c++) {
+    const char* escaped = nullptr;
+    switch (*c) {
+      case '"':
+        escaped = "\\\"";
+        break;
+      case '\\':
+        escaped = "\\\\";
+        break;
+      case '\b':
+        escaped = "\\b";
+        break;
+      case '\f':
+        escaped = "\\f";
+        break;
+      case '\n':
+        escaped = "\\n";
+        break;
+      case '\r':
+        escaped = "\\r";
+        break;
+      case '\t':
+        escaped = "\\t";
+        break;
+    }
+    if (escaped) {
+      out.write((const uint8_t*)escaped, 2);
+    } else {
+      out.write((uint8_t)*c);
+    }
+  }
+  out.write('"');
+}
+
+void ChunkedJsonWriter::step() {
+  if (!_started) {
+    _started = writeValue(_jsonDocument->as<JsonVariant>());
+    return;
+  }
+  // writing a value may push a level, which leaves this one in place
+  Level& level = _levels[_depth - 1];
+  if (level.object) {
+    if (!(level.member != level.memberEnd)) {
+      if (writeText("}")) {
+        _depth--;
+      }
+    } else if (!level.prefixed) {
+      ChunkPrint window = this->window();
+      JsonPair member = *level.member;
+      JsonString key = member.key();
+      if (!level.first) {
+        window.write(',');
+      }
+      writeString(window, key.c_str());
+      window.write(':');
+      level.prefixed = complete(window);
+    } else if (writeValue((*level.member).value())) {
+      ++level.member;
+      level.first = false;
+      level.prefixed = false;
+    }
+  } else {
+    if (!(level.element != level.elementEnd)) {
+      if (writeText("]")) {
+        _depth--;
+      }
+    } else if (!level.prefixed) {
+      level.prefixed = level.first || writeText(",");
+    } else if (writeValue(*level.element)) {
+      ++level.element;
+      level.first = false;
+      level.prefixed = false;
+    }
+  }
+}
+
+bool ChunkedJsonWriter::writeValue(JsonVariant value) {
+  if (_depth < CHUNKED_JSON_MAX_DEPTH && value.is<JsonObject>()) {
+    if (!writeText("{")) {
+      return false;
+    }
+    JsonObject object = value.as<JsonObject>();
+    Level& level = _levels[_depth++];
+    level.object = true;
+    level.first = true;
+    level.prefixed = false;
+    level.member = object.begin();
+    level.memberEnd = object.end();
+    return true;
+  }
+  if (_depth < CHUNKED_JSON_MAX_DEPTH && value.is<JsonArray>()) {
+    if (!writeText("[")) {
+      return false;
+    }
+    JsonArray array = value.as<JsonArray>();
+    Level& level = _levels[_depth++];
+    level.object = false;
+    level.first = true;
+    level.prefixed = false;
+    level.element = array.begin();
+    level.elementEnd = array.end();
+    return true;
+  }
+  ChunkPrint window = this->window();
+  serializeJson(value, window);
+  return complete(window);
+}
+
+bool ChunkedJsonWriter::writeText(const char* text) {
+  ChunkPrint window = this->window();
+  window.write((const uint8_t*)text, strlen(text));
+  return complete(window);
+}
+
+ChunkPrint ChunkedJsonWriter::window() {
+  return ChunkPrint(_buffer + _length, _maxLen - _length, _offset);
+}
+
+bool ChunkedJsonWriter::complete(const ChunkPrint& window) {
+  _length += window.length();
+  if (window.complete()) {
+    _offset = 0;
+    return true;
+  }
+  _offset += window.length();
+  return false;
+}
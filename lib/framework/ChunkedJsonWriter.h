@@ -0,0 +1,107 @@
+#ifndef ChunkedJsonWriter_h
+#define ChunkedJsonWriter_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Keeps the bytes of a serialization which fall within a window, starting index bytes in and at most maxLen long, and
+ * counts the rest without storing them.
+ */
+class ChunkPrint : public Print {
+ public:
+  ChunkPrint(uint8_t* buffer, size_t maxLen, size_t index) :
+      _buffer(buffer), _maxLen(maxLen), _index(index), _position(0) {
+  }
+
+  size_t write(uint8_t c) {
+    return write(&c, 1);
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) {
+    size_t start = _position > _index ? _position : _index;
+    size_t end = _position + size < _index + _maxLen ? _position + size : _index + _maxLen;
+    if (start < end) {
+      memcpy(_buffer + start - _index, buffer + start - _position, end - start);
+    }
+    _position += size;
+    return size;
+  }
+
+  // true if the window reached the end of everything written
+  bool complete() const {
+    return _position <= _index + _maxLen;
+  }
+
+  // the number of bytes written to the buffer
+  size_t length() const {
+    if (_position <= _index) {
+      return 0;
+    }
+    return _position - _index < _maxLen ? _position - _index : _maxLen;
+  }
+
+ private:
+  uint8_t* _buffer;
+  size_t _maxLen;
+  size_t _index;
+  size_t _position;
+};
+
+// containers nested deeper than this are serialized whole each time a chunk boundary falls within them
+#ifndef CHUNKED_JSON_MAX_DEPTH
+#define CHUNKED_JSON_MAX_DEPTH 8
+#endif
+
+/**
+ * Serializes a JSON document a chunk at a time, resuming where the previous chunk ended. The document is walked with
+ * a stack of iterators and each value is written once, only a value which straddles a chunk boundary is serialized
+ * again for the next chunk.
+ */
+class ChunkedJsonWriter {
+ public:
+  ChunkedJsonWriter();
+
+  // starts writing the document, which must outlive the writer or the next call to begin()
+  void begin(JsonDocument* jsonDocument);
+
+  // writes the next bytes of the serialization, at most maxLen, returning the number written
+  size_t write(uint8_t* buffer, size_t maxLen);
+
+  bool done() const {
+    return _started && !_depth;
+  }
+
+  // writes a string as a quoted JSON string, escaped as ArduinoJson does
+  static void writeString(Print& out, const char* value);
+
+ private:
+  struct Level {
+    bool object;
+    bool first;
+    // the comma and member key have been written for the current value
+    bool prefixed;
+    JsonObject::iterator member;
+    JsonObject::iterator memberEnd;
+    JsonArray::iterator element;
+    JsonArray::iterator elementEnd;
+  };
+
+  JsonDocument* _jsonDocument;
+  Level _levels[CHUNKED_JSON_MAX_DEPTH];
+  uint8_t _depth;
+  bool _started;
+  // the number of bytes of the current token written by previous chunks
+  size_t _offset;
+  uint8_t* _buffer;
+  size_t _maxLen;
+  size_t _length;
+
+  void step();
+  bool writeValue(JsonVariant value);
+  bool writeText(const char* text);
+  ChunkPrint window();
+  bool complete(const ChunkPrint& window);
+};
+
+#endif  // end ChunkedJsonWriter_h
@@ -0,0 +1,316 @@
+#include <ConfigStore.h>
+
+// a record is a magic byte, the key length, the value length (little endian), the key, the value and then the CRC32
+// of everything before it (little endian)
+#define CONFIG_STORE_RECORD_MAGIC 0xc5
+#define CONFIG_STORE_HEADER_LENGTH 4
+#define CONFIG_STORE_CRC_LENGTH 4
+#define CONFIG_STORE_TEMP_SUFFIX "+"
+
+ConfigStore* ConfigStore::_first = nullptr;
+
+ConfigStore::ConfigStore(FS* fs, const char* filePath) :
+    _fs(fs),
+    _filePath(filePath),
+    _next(nullptr),
+    _loopHook(compactIfPending, this),
+#ifdef ESP32
+    _accessMutex(xSemaphoreCreateRecursiveMutex()),
+#endif
+    _entryCount(0),
+    _size(0),
+    _loaded(false),
+    _damaged(false),
+    _compactionPending(false) {
+  // attached for good as hooks may not be attached from the tasks writes are made from
+  _loopHook.attach();
+}
+
+ConfigStore* ConfigStore::forFS(FS* fs) {
+  ConfigStore* store = _first;
+  while (store && store->_fs != fs) {
+    store = store->_next;
+  }
+  if (!store) {
+    store = new ConfigStore(fs);
+    store->_next = _first;
+    _first = store;
+  }
+  return store;
+}
+
+void ConfigStore::resetAll() {
+  for (ConfigStore* store = _first; store; store = store->_next) {
+    store->reset();
+  }
+}
+
+bool ConfigStore::contains(const char* key) {
+  beginTransaction();
+  load();
+  bool found = find(key) != nullptr;
+  endTransaction();
+  return found;
+}
+
+bool ConfigStore::read(const char* key, JsonDocument& jsonDocument, JsonFileFormat& format) {
+  beginTransaction();
+  load();
+  Entry* entry = find(key);
+  bool success = false;
+  if (entry) {
+    File file = _fs->open(_filePath, "r");
+    if (file && file.seek(entry->offset + CONFIG_STORE_HEADER_LENGTH + entry->key.length())) {
+      // the checksum was verified when the log was scanned, parsing stops at the end of the value
+      success = ChecksumFile::read(jsonDocument, file, format) == DeserializationError::Ok;
+    }
+    file.close();
+  }
+  endTransaction();
+  return success;
+}
+
+bool ConfigStore::write(const char* key, JsonDocument& jsonDocument, JsonFileFormat format) {
+  size_t keyLength = strlen(key);
+  size_t valueLength = ChecksumFile::measure(jsonDocument, format);
+  if (keyLength > 0xff || valueLength > 0xffff) {
+    return false;
+  }
+
+  beginTransaction();
+  load();
+  // anything appended after a damaged record would be lost on the next scan
+  if (_damaged && !compactLocked()) {
+    endTransaction();
+    return false;
+  }
+  Entry* entry = find(key);
+  if (!entry && _entryCount == CONFIG_STORE_MAX_KEYS) {
+    endTransaction();
+    return false;
+  }
+
+  File file = _fs->open(_filePath, "a");
+  if (!file) {
+    endTransaction();
+    return false;
+  }
+  ChecksumPrint checksumPrint(file);
+  uint8_t header[CONFIG_STORE_HEADER_LENGTH] = {
+      CONFIG_STORE_RECORD_MAGIC, (uint8_t)keyLength, (uint8_t)valueLength, (uint8_t)(valueLength >> 8)};
+  bool written = checksumPrint.write(header, sizeof(header)) == sizeof(header) &&
+                 checksumPrint.write((const uint8_t*)key, keyLength) == keyLength &&
+                 ChecksumFile::serialize(jsonDocument, checksumPrint, format) == valueLength;
+  if (written) {
+    uint32_t crc = checksumPrint.crc();
+    uint8_t trailer[CONFIG_STORE_CRC_LENGTH] = {
+        (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)};
+    written = file.write(trailer, sizeof(trailer)) == sizeof(trailer);
+  }
+  file.close();
+
+  uint32_t length = CONFIG_STORE_HEADER_LENGTH + keyLength + valueLength + CONFIG_STORE_CRC_LENGTH;
+  if (!written) {
+    // the partial record is dropped before the next write
+    _damaged = true;
+  } else {
+    if (!entry) {
+      entry = &_entries[_entryCount++];
+      entry->key = key;
+    }
+    entry->offset = _size;
+    entry->valueLength = valueLength;
+    if (_size + length > CONFIG_STORE_COMPACT_SIZE && _size + length > 2 * liveSizeLocked()) {
+      _compactionPending = true;
+    }
+  }
+  _size += length;
+  endTransaction();
+  return written;
+}
+
+bool ConfigStore::compact() {
+  beginTransaction();
+  load();
+  bool compacted = compactLocked();
+  endTransaction();
+  return compacted;
+}
+
+void ConfigStore::reset() {
+  beginTransaction();
+  _fs->remove(_filePath);
+  _entryCount = 0;
+  _size = 0;
+  _loaded = true;
+  _damaged = false;
+  _compactionPending = false;
+  endTransaction();
+}
+
+size_t ConfigStore::size() {
+  beginTransaction();
+  load();
+  size_t size = _size;
+  endTransaction();
+  return size;
+}
+
+size_t ConfigStore::liveSize() {
+  beginTransaction();
+  load();
+  size_t size = liveSizeLocked();
+  endTransaction();
+  return size;
+}
+
+void ConfigStore::load() {
+  if (_loaded) {
+    return;
+  }
+  _loaded = true;
+
+  // a temp file left by compaction is complete only if the log had already been removed
+  String tempPath = _filePath + CONFIG_STORE_TEMP_SUFFIX;
+  if (_fs->exists(tempPath)) {
+    if (_fs->exists(_filePath)) {
+      _fs->remove(tempPath);
+    } else {
+      _fs->rename(tempPath, _filePath);
+    }
+  }
+
+  File file = _fs->open(_filePath, "r");
+  if (!file) {
+    return;
+  }
+  uint32_t size = file.size();
+  String key;
+  uint16_t valueLength;
+  while (_size < size && readRecord(file, _size, size, key, valueLength)) {
+    Entry* entry = find(key.c_str());
+    if (!entry) {
+      if (_entryCount == CONFIG_STORE_MAX_KEYS) {
+        break;
+      }
+      entry = &_entries[_entryCount++];
+      entry->key = key;
+    }
+    entry->offset = _size;
+    entry->valueLength = valueLength;
+    _size += recordLength(*entry);
+  }
+  file.close();
+  _damaged = _size < size;
+  // writes are appended to the end of the file, which is where the damaged tail is dropped from
+  if (_damaged) {
+    _size = size;
+  }
+}
+
+bool ConfigStore::readRecord(File& file, uint32_t offset, uint32_t size, String& key, uint16_t& valueLength) {
+  uint8_t buffer[64];
+  if (size - offset < CONFIG_STORE_HEADER_LENGTH + CONFIG_STORE_CRC_LENGTH || !file.seek(offset) ||
+      file.read(buffer, CONFIG_STORE_HEADER_LENGTH) != CONFIG_STORE_HEADER_LENGTH ||
+      buffer[0] != CONFIG_STORE_RECORD_MAGIC) {
+    return false;
+  }
+  uint8_t keyLength = buffer[1];
+  valueLength = buffer[2] | buffer[3] << 8;
+  if (size - offset < (uint32_t)CONFIG_STORE_HEADER_LENGTH + keyLength + valueLength + CONFIG_STORE_CRC_LENGTH) {
+    return false;
+  }
+  uint32_t crc = ChecksumFile::crc32(buffer, CONFIG_STORE_HEADER_LENGTH);
+
+  char keyBuffer[0x100];
+  if (file.read((uint8_t*)keyBuffer, keyLength) != keyLength) {
+    return false;
+  }
+  keyBuffer[keyLength] = '\0';
+  crc = ChecksumFile::crc32((const uint8_t*)keyBuffer, keyLength, crc);
+
+  for (size_t remaining = valueLength; remaining > 0;) {
+    size_t read = file.read(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+    if (!read) {
+      return false;
+    }
+    crc = ChecksumFile::crc32(buffer, read, crc);
+    remaining -= read;
+  }
+  if (file.read(buffer, CONFIG_STORE_CRC_LENGTH) != CONFIG_STORE_CRC_LENGTH) {
+    return false;
+  }
+  if (crc != (buffer[0] | buffer[1] << 8 | buffer[2] << 16 | (uint32_t)buffer[3] << 24)) {
+    return false;
+  }
+  key = keyBuffer;
+  return true;
+}
+
+ConfigStore::Entry* ConfigStore::find(const char* key) {
+  for (uint8_t i = 0; i < _entryCount; i++) {
+    if (_entries[i].key == key) {
+      return &_entries[i];
+    }
+  }
+  return nullptr;
+}
+
+bool ConfigStore::compactLocked() {
+  _compactionPending = false;
+  String tempPath = _filePath + CONFIG_STORE_TEMP_SUFFIX;
+  File source = _fs->open(_filePath, "r");
+  File target = _fs->open(tempPath, "w");
+  bool copied = source && target;
+  uint8_t buffer[64];
+  for (uint8_t i = 0; i < _entryCount && copied; i++) {
+    copied = source.seek(_entries[i].offset);
+    for (size_t remaining = recordLength(_entries[i]); remaining > 0 && copied;) {
+      size_t read = source.read(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+      copied = read && target.write(buffer, read) == read;
+      remaining -= read;
+    }
+  }
+  source.close();
+  target.close();
+  if (!copied) {
+    _fs->remove(tempPath);
+    return false;
+  }
+
+  // a reset between these leaves only the temp file, which load() moves into place
+  _fs->remove(_filePath);
+  if (!_fs->rename(tempPath, _filePath)) {
+    // rescanned on next use, once the temp file has been moved into place
+    _entryCount = 0;
+    _size = 0;
+    _loaded = false;
+    return false;
+  }
+  _size = 0;
+  for (uint8_t i = 0; i < _entryCount; i++) {
+    _entries[i].offset = _size;
+    _size += recordLength(_entries[i]);
+  }
+  _damaged = false;
+  return true;
+}
+
+uint32_t ConfigStore::liveSizeLocked() {
+  uint32_t size = 0;
+  for (uint8_t i = 0; i < _entryCount; i++) {
+    size += recordLength(_entries[i]);
+  }
+  return size;
+}
+
+uint32_t ConfigStore::recordLength(const Entry& entry) {
+  return CONFIG_STORE_HEADER_LENGTH + entry.key.length() + entry.valueLength + CONFIG_STORE_CRC_LENGTH;
+}
+
+void ConfigStore::compactIfPending(void* context) {
+  ConfigStore* store = static_cast<ConfigStore*>(context);
+  if (store->_compactionPending) {
+    store->compact();
+  }
+}
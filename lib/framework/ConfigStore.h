@@ -0,0 +1,101 @@
+#ifndef ConfigStore_h
+#define ConfigStore_h
+
+#include <ChecksumFile.h>
+#include <LoopHook.h>
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
+
+#ifndef CONFIG_STORE_FILE
+#define CONFIG_STORE_FILE "/config/store.log"
+#endif
+
+#ifndef CONFIG_STORE_MAX_KEYS
+#define CONFIG_STORE_MAX_KEYS 16
+#endif
+
+// the log is compacted once it is larger than this and holds more superseded records than current ones
+#ifndef CONFIG_STORE_COMPACT_SIZE
+#define CONFIG_STORE_COMPACT_SIZE 8192
+#endif
+
+/**
+ * Keeps the state of every FSPersistence instance on a filesystem in a single append-only log, rather than a file per
+ * service, so booting reads one file and saving a change appends a record instead of rewriting a file.
+ *
+ * Each record holds a key, the serialized state and a CRC32 of both, the latest intact record for a key is current. The
+ * log is scanned once, on first use, to index the current records. A record cut short by a reset mid-write fails its
+ * checksum, so the key's previous record remains current, and the damaged tail is dropped before anything else is
+ * appended.
+ *
+ * Once superseded records make up most of the log it is compacted from ESP8266React::loop(), by copying the current
+ * records to a new file which then replaces the log.
+ */
+class ConfigStore {
+ public:
+  ConfigStore(FS* fs, const char* filePath = CONFIG_STORE_FILE);
+
+  // the store shared by all persistence on the filesystem
+  static ConfigStore* forFS(FS* fs);
+
+  // truncates every store, used by factory reset
+  static void resetAll();
+
+  bool contains(const char* key);
+  bool read(const char* key, JsonDocument& jsonDocument, JsonFileFormat& format);
+  bool write(const char* key, JsonDocument& jsonDocument, JsonFileFormat format);
+  bool compact();
+  void reset();
+
+  size_t size();
+  size_t liveSize();
+
+ private:
+  struct Entry {
+    String key;
+    uint32_t offset;
+    uint16_t valueLength;
+  };
+
+  static ConfigStore* _first;
+
+  FS* _fs;
+  String _filePath;
+  ConfigStore* _next;
+  LoopHook _loopHook;
+#ifdef ESP32
+  SemaphoreHandle_t _accessMutex;
+#endif
+  Entry _entries[CONFIG_STORE_MAX_KEYS];
+  uint8_t _entryCount;
+  uint32_t _size;
+  bool _loaded;
+  bool _damaged;
+  bool _compactionPending;
+
+  void load();
+  bool readRecord(File& file, uint32_t offset, uint32_t size, String& key, uint16_t& valueLength);
+  Entry* find(const char* key);
+  bool compactLocked();
+  uint32_t liveSizeLocked();
+
+  static uint32_t recordLength(const Entry& entry);
+  static void compactIfPending(void* context);
+
+  inline void beginTransaction() {
+#ifdef ESP32
+    xSemaphoreTakeRecursive(_accessMutex, portMAX_DELAY);
+#endif
+  }
+
+  inline void endTransaction() {
+#ifdef ESP32
+    xSemaphoreGiveRecursive(_accessMutex);
+#endif
+  }
+};
+
+#endif  // end ConfigStore_h
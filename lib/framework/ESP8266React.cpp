@@ -27,7 +27,14 @@ ESP8266React::ESP8266React(AsyncWebServer* server) :
 #endif
     _restartService(server, &_securitySettingsService),
     _factoryResetService(server, &ESPFS, &_securitySettingsService),
-    _systemStatus(server, &_securitySettingsService) {
+    _systemStatus(server, &_securitySettingsService),
+    _persistenceStats(server, &_securitySettingsService),
+    _bootProfile(server, &_securitySettingsService),
+    _webSocketStats(server, &_securitySettingsService),
+    _batchEndpoint(server, &_securitySettingsService),
+    _webSocketHub(server, &_securitySettingsService),
+    _deferredBeginCount(0),
+    _deferredBegun(0) {
 #ifdef PROGMEM_WWW
   // Serve static resources from PROGMEM
   WWWData::registerRoutes(
@@ -78,31 +85,96 @@ ESP8266React::ESP8266React(AsyncWebServer* server) :
   DefaultHeaders::Instance().addHeader("Access-Control-Allow-Headers", "Accept, Content-Type, Authorization");
   DefaultHeaders::Instance().addHeader("Access-Control-Allow-Credentials", "true");
 #endif
+
+  registerBatchSources();
+}
+
+void ESP8266React::registerBatchSources() {
+  _batchEndpoint.addReader("wifiStatus", WiFiStatus::read, &_wifiStatus, MAX_WIFI_STATUS_SIZE);
+  _batchEndpoint.addReader("apStatus", APStatus::read, &_apStatus, MAX_AP_STATUS_SIZE);
+  _batchEndpoint.addReader("systemStatus", SystemStatus::read, &_systemStatus, MAX_ESP_STATUS_SIZE);
+  _batchEndpoint.addService("wifiSettings", &_wifiSettingsService, WiFiSettings::read, WiFiSettings::update);
+  _batchEndpoint.addService("apSettings", &_apSettingsService, APSettings::read, APSettings::update);
+#if FT_ENABLED(FT_NTP)
+  _batchEndpoint.addReader("ntpStatus", NTPStatus::read, &_ntpStatus, MAX_NTP_STATUS_SIZE);
+  _batchEndpoint.addService("ntpSettings",
+                            &_ntpSettingsService,
+                            NTPSettingsFields::read,
+                            NTPSettingsFields::update,
+                            AuthenticationPredicates::IS_ADMIN,
+                            NTPSettingsFields::capacity());
+#endif
+#if FT_ENABLED(FT_OTA)
+  _batchEndpoint.addService("otaSettings",
+                            &_otaSettingsService,
+                            OTASettingsFields::read,
+                            OTASettingsFields::update,
+                            AuthenticationPredicates::IS_ADMIN,
+                            OTASettingsFields::capacity());
+#endif
+#if FT_ENABLED(FT_MQTT)
+  _batchEndpoint.addReader("mqttStatus", MqttStatus::read, &_mqttStatus, MAX_MQTT_STATUS_SIZE);
+  _batchEndpoint.addService("mqttSettings", &_mqttSettingsService, MqttSettings::read, MqttSettings::update);
+#endif
+#if FT_ENABLED(FT_SECURITY)
+  _batchEndpoint.addService(
+      "securitySettings", &_securitySettingsService, SecuritySettings::read, SecuritySettings::update);
+#endif
 }
 
 void ESP8266React::begin() {
 #ifdef ESP32
-  ESPFS.begin(true);
+  BootProfile::measure("fs_mount", []() { ESPFS.begin(true); });
 #elif defined(ESP8266)
-  ESPFS.begin();
+  BootProfile::measure("fs_mount", []() { ESPFS.begin(); });
+#endif
+  BootProfile::measure("wifi_settings", [this]() { _wifiSettingsService.begin(); });
+  BootProfile::measure("ap_settings", [this]() { _apSettingsService.begin(); });
+#if FT_ENABLED(FT_SECURITY)
+  BootProfile::measure("security_settings", [this]() { _securitySettingsService.begin(); });
 #endif
-  _wifiSettingsService.begin();
-  _apSettingsService.begin();
 #if FT_ENABLED(FT_NTP)
-  _ntpSettingsService.begin();
+  deferBegin(
+      "ntp_settings", [](void* context) { static_cast<NTPSettingsService*>(context)->begin(); }, &_ntpSettingsService);
 #endif
 #if FT_ENABLED(FT_OTA)
-  _otaSettingsService.begin();
+  deferBegin(
+      "ota_settings", [](void* context) { static_cast<OTASettingsService*>(context)->begin(); }, &_otaSettingsService);
 #endif
 #if FT_ENABLED(FT_MQTT)
-  _mqttSettingsService.begin();
-#endif
-#if FT_ENABLED(FT_SECURITY)
-  _securitySettingsService.begin();
+  deferBegin(
+      "mqtt_settings",
+      [](void* context) { static_cast<MqttSettingsService*>(context)->begin(); },
+      &_mqttSettingsService);
 #endif
+  // handlers are registered as the services are constructed, before the serial port has been started
+  if (StateUpdateHandlerInfo_t::refusedCount) {
+    Serial.printf_P(PSTR("%u update handler(s) refused by a full handler table, see StateTraits\r\n"),
+                    StateUpdateHandlerInfo_t::refusedCount);
+  }
+}
+
+void ESP8266React::deferBegin(const char* name, BeginFunction beginFunction, void* context) {
+  if (!ESP8266REACT_DEFER_BEGIN || _deferredBeginCount == ESP8266REACT_MAX_DEFERRED_BEGINS) {
+    BootProfile::measure(name, [beginFunction, context]() { beginFunction(context); });
+    return;
+  }
+  _deferredBegins[_deferredBeginCount++] = {name, beginFunction, context};
+}
+
+void ESP8266React::beginDeferred() {
+  DeferredBegin& deferred = _deferredBegins[_deferredBegun++];
+  BootProfile::measure(deferred.name, [&deferred]() { deferred.beginFunction(deferred.context); });
+  if (_deferredBegun == _deferredBeginCount) {
+    BootProfile::mark("deferred_begun");
+  }
 }
 
 void ESP8266React::loop() {
+  if (_deferredBegun < _deferredBeginCount) {
+    beginDeferred();
+  }
+  LoopHook::loopAll();
   _wifiSettingsService.loop();
   _apSettingsService.loop();
 #if FT_ENABLED(FT_OTA)
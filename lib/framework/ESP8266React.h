@@ -15,16 +15,22 @@
 #include <APSettingsService.h>
 #include <APStatus.h>
 #include <AuthenticationService.h>
+#include <BatchEndpoint.h>
+#include <BootProfile.h>
 #include <FactoryResetService.h>
+#include <LoopHook.h>
 #include <MqttSettingsService.h>
 #include <MqttStatus.h>
 #include <NTPSettingsService.h>
 #include <NTPStatus.h>
 #include <OTASettingsService.h>
+#include <PersistenceStats.h>
 #include <UploadFirmwareService.h>
 #include <RestartService.h>
 #include <SecuritySettingsService.h>
 #include <SystemStatus.h>
+#include <WebSocketHub.h>
+#include <WebSocketStats.h>
 #include <WiFiScanner.h>
 #include <WiFiSettingsService.h>
 #include <WiFiStatus.h>
@@ -34,13 +40,33 @@
 #include <WWWData.h>
 #endif
 
+// Loads for NTP, OTA and MQTT settings are deferred until after setup() unless this is set to 0
+#ifndef ESP8266REACT_DEFER_BEGIN
+#define ESP8266REACT_DEFER_BEGIN 1
+#endif
+
+#ifndef ESP8266REACT_MAX_DEFERRED_BEGINS
+#define ESP8266REACT_MAX_DEFERRED_BEGINS 8
+#endif
+
 class ESP8266React {
  public:
+  typedef void (*BeginFunction)(void* context);
+
   ESP8266React(AsyncWebServer* server);
 
   void begin();
   void loop();
 
+  /**
+   * Defers a service's begin function to loop(), which runs one deferred function per pass in the order they were
+   * deferred, so loads which are not needed to bring the device up happen after setup() has started the web server.
+   * A service which depends on another is deferred after it. A deferred service must ignore WiFi events until its
+   * begin function has run, which configures it for the connection state at that point. Each deferred function is timed
+   * in the boot profile.
+   */
+  void deferBegin(const char* name, BeginFunction beginFunction, void* context);
+
   FS* getFS() {
     return &ESPFS;
   }
@@ -49,6 +75,16 @@ class ESP8266React {
     return &_securitySettingsService;
   }
 
+  // the framework's status providers and settings services are registered, applications may add their own services
+  BatchEndpoint* getBatchEndpoint() {
+    return &_batchEndpoint;
+  }
+
+  // serves the channels registered by the application over a single WebSocket
+  WebSocketHub* getWebSocketHub() {
+    return &_webSocketHub;
+  }
+
 #if FT_ENABLED(FT_SECURITY)
   StatefulService<SecuritySettings>* getSecuritySettingsService() {
     return &_securitySettingsService;
@@ -117,6 +153,24 @@ class ESP8266React {
   RestartService _restartService;
   FactoryResetService _factoryResetService;
   SystemStatus _systemStatus;
+  PersistenceStats _persistenceStats;
+  BootProfile _bootProfile;
+  WebSocketStats _webSocketStats;
+  BatchEndpoint _batchEndpoint;
+  WebSocketHub _webSocketHub;
+
+  struct DeferredBegin {
+    const char* name;
+    BeginFunction beginFunction;
+    void* context;
+  };
+
+  DeferredBegin _deferredBegins[ESP8266REACT_MAX_DEFERRED_BEGINS];
+  uint8_t _deferredBeginCount;
+  uint8_t _deferredBegun;
+
+  void beginDeferred();
+  void registerBatchSources();
 };
 
 #endif
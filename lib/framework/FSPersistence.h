@@ -1,9 +1,38 @@
 #ifndef FSPersistence_h
 #define FSPersistence_h
 
+#include <ChecksumFile.h>
+#include <ConfigStore.h>
+#include <PersistenceStats.h>
 #include <StatefulService.h>
+#include <WriteBehind.h>
 #include <FS.h>
 
+// Suffixes are kept to one character as SPIFFS limits paths to 31 characters
+#ifndef FS_PERSISTENCE_TEMP_SUFFIX
+#define FS_PERSISTENCE_TEMP_SUFFIX "+"
+#endif
+
+#ifndef FS_PERSISTENCE_BACKUP_SUFFIX
+#define FS_PERSISTENCE_BACKUP_SUFFIX "~"
+#endif
+
+// State is written as MessagePack unless this is set to 0, files in either format are read
+#ifndef FS_PERSISTENCE_MSGPACK
+#define FS_PERSISTENCE_MSGPACK 1
+#endif
+
+// State is kept in the filesystem's ConfigStore unless this is set to 0, when each instance writes its own file
+#ifndef FS_PERSISTENCE_CONFIG_STORE
+#define FS_PERSISTENCE_CONFIG_STORE 1
+#endif
+
+#if FS_PERSISTENCE_MSGPACK
+#define FS_PERSISTENCE_FORMAT JsonFileFormat::MESSAGE_PACK
+#else
+#define FS_PERSISTENCE_FORMAT JsonFileFormat::JSON
+#endif
+
 template <class T>
 class FSPersistence {
  public:
@@ -18,24 +47,53 @@ class FSPersistence {
       _statefulService(statefulService),
       _fs(fs),
       _filePath(filePath),
+      _configStore(FS_PERSISTENCE_CONFIG_STORE ? ConfigStore::forFS(fs) : nullptr),
       _bufferSize(bufferSize),
+      _counters(filePath),
+      _persistedFields(ALL_STATE_FIELDS),
+      _writeBehind(writePending, this),
       _updateHandlerId(0) {
     enableUpdateHandler();
   }
 
+  /**
+   * Loads the state from the ConfigStore, keyed by the file path, or from the newest intact copy of the file. A
+   * complete temp file is newer than the file itself, it is left behind if the device resets between the renames in
+   * writeToFS(). The backup holds the copy before that. The copy loaded is moved into place, or into the ConfigStore if
+   * it is in use, defaults are applied if there is none. State in the other format is rewritten once in the configured
+   * format.
+   */
   void readFromFS() {
-    File settingsFile = _fs->open(_filePath, "r");
-
-    if (settingsFile) {
-      DynamicJsonDocument jsonDocument = DynamicJsonDocument(_bufferSize);
-      DeserializationError error = deserializeJson(jsonDocument, settingsFile);
-      if (error == DeserializationError::Ok && jsonDocument.is<JsonObject>()) {
-        JsonObject jsonObject = jsonDocument.as<JsonObject>();
-        _statefulService->updateWithoutPropagation(jsonObject, _stateUpdater);
-        settingsFile.close();
+    JsonFileFormat format;
+    if (_configStore) {
+      PooledJsonDocument jsonDocument(_bufferSize);
+      if (_configStore->read(_filePath, jsonDocument, format) && updateFrom(jsonDocument)) {
+        loaded(format);
+        return;
+      }
+    }
+
+    String candidates[] = {String(_filePath) + FS_PERSISTENCE_TEMP_SUFFIX,
+                           _filePath,
+                           String(_filePath) + FS_PERSISTENCE_BACKUP_SUFFIX};
+    for (const String& candidate : candidates) {
+      if (readFile(candidate, format)) {
+        if (_configStore) {
+          // files written before the store was in use are moved into it
+          if (writeToFS()) {
+            for (const String& path : candidates) {
+              _fs->remove(path);
+            }
+          }
+          return;
+        }
+        if (candidate != _filePath) {
+          _fs->remove(_filePath);
+          _fs->rename(candidate, _filePath);
+        }
+        loaded(format);
         return;
       }
-      settingsFile.close();
     }
 
     // If we reach here we have not been successful in loading the config,
@@ -43,26 +101,54 @@ class FSPersistence {
     applyDefaults();
   }
 
+  /**
+   * Appends the state to the ConfigStore or writes it to a temp file with a checksum trailer, then swaps it in for the
+   * file, keeping the previous file as a backup. A reset part way through leaves either the previous file or the
+   * complete temp file to load.
+   *
+   * Nothing is written if the state serializes to the same bytes as it did when it was last written or loaded.
+   */
   bool writeToFS() {
     // create and populate a new json object
-    DynamicJsonDocument jsonDocument = DynamicJsonDocument(_bufferSize);
+    PooledJsonDocument jsonDocument(_bufferSize);
     JsonObject jsonObject = jsonDocument.to<JsonObject>();
     _statefulService->read(jsonObject, _stateReader);
 
-    // serialize it to filesystem
-    File settingsFile = _fs->open(_filePath, "w");
-
-    // failed to open file, return false
-    if (!settingsFile) {
+    uint32_t crc = ChecksumFile::checksum(jsonDocument, FS_PERSISTENCE_FORMAT);
+    if (_counters.matches(crc)) {
+      _counters.skipped();
+      return true;
+    }
+    _counters.written();
+    if (!writeDocument(jsonDocument)) {
       return false;
     }
-
-    // serialize the data to the file
-    serializeJson(jsonDocument, settingsFile);
-    settingsFile.close();
+    _counters.persisted(crc);
     return true;
   }
 
+  /**
+   * Restricts writes to updates which change one of the given fields, for state types derived from TrackedState which
+   * hold fields that are not persisted. The whole state is still written.
+   */
+  void setPersistedFields(state_field_mask_t persistedFields) {
+    _persistedFields = persistedFields;
+  }
+
+  /**
+   * Writes changes from the loop rather than as they are made, once no further changes have been made for quietPeriod
+   * milliseconds or at most maxDelay milliseconds after the first unwritten change. Pending writes are flushed before
+   * the device restarts, is factory reset or has its firmware updated.
+   */
+  void writeBehind(uint32_t quietPeriod, uint32_t maxDelay) {
+    _writeBehind.enable(quietPeriod, maxDelay);
+  }
+
+  // writes any pending changes now
+  void flush() {
+    _writeBehind.flush();
+  }
+
   void disableUpdateHandler() {
     if (_updateHandlerId) {
       _statefulService->removeUpdateHandler(_updateHandlerId);
@@ -72,7 +158,19 @@ class FSPersistence {
 
   void enableUpdateHandler() {
     if (!_updateHandlerId) {
-      _updateHandlerId = _statefulService->addUpdateHandler([&](const String& originId) { writeToFS(); });
+      _updateHandlerId = _statefulService->addUpdateHandler(
+          [](void* context, const String& originId, state_field_mask_t changedFields) {
+            FSPersistence<T>* fsPersistence = static_cast<FSPersistence<T>*>(context);
+            if (!(changedFields & fsPersistence->_persistedFields)) {
+              return;
+            }
+            if (fsPersistence->_writeBehind.isEnabled()) {
+              fsPersistence->_writeBehind.schedule();
+            } else {
+              fsPersistence->writeToFS();
+            }
+          },
+          this);
     }
   }
 
@@ -82,14 +180,89 @@ class FSPersistence {
   StatefulService<T>* _statefulService;
   FS* _fs;
   char const* _filePath;
+  ConfigStore* _configStore;
   size_t _bufferSize;
+  PersistenceCounters _counters;
+  state_field_mask_t _persistedFields;
+  WriteBehind _writeBehind;
   update_handler_id_t _updateHandlerId;
 
+  bool readFile(const String& path, JsonFileFormat& format) {
+    File settingsFile = _fs->open(path, "r");
+    if (!settingsFile) {
+      return false;
+    }
+    bool loaded = false;
+    if (ChecksumFile::verify(settingsFile)) {
+      // files written by earlier firmware may hold longer strings than the buffer is sized for
+      PooledJsonDocument jsonDocument(_bufferSize + settingsFile.size());
+      DeserializationError error = ChecksumFile::read(jsonDocument, settingsFile, format);
+      loaded = error == DeserializationError::Ok && updateFrom(jsonDocument);
+    }
+    settingsFile.close();
+    return loaded;
+  }
+
+  bool writeDocument(JsonDocument& jsonDocument) {
+    if (_configStore) {
+      return _configStore->write(_filePath, jsonDocument, FS_PERSISTENCE_FORMAT);
+    }
+
+    // serialize it to the temp file
+    String tempPath = String(_filePath) + FS_PERSISTENCE_TEMP_SUFFIX;
+    File settingsFile = _fs->open(tempPath, "w");
+
+    // failed to open file, return false
+    if (!settingsFile) {
+      return false;
+    }
+
+    bool written = ChecksumFile::write(jsonDocument, settingsFile, FS_PERSISTENCE_FORMAT);
+    settingsFile.close();
+    if (!written) {
+      _fs->remove(tempPath);
+      return false;
+    }
+
+    // SPIFFS can not rename over an existing file
+    if (_fs->exists(_filePath)) {
+      String backupPath = String(_filePath) + FS_PERSISTENCE_BACKUP_SUFFIX;
+      _fs->remove(backupPath);
+      _fs->rename(_filePath, backupPath);
+    }
+    return _fs->rename(tempPath, _filePath);
+  }
+
+  // state in the other format is rewritten, otherwise the state as loaded is what is on flash
+  void loaded(JsonFileFormat format) {
+    if (format != FS_PERSISTENCE_FORMAT) {
+      writeToFS();
+      return;
+    }
+    PooledJsonDocument jsonDocument(_bufferSize);
+    JsonObject jsonObject = jsonDocument.to<JsonObject>();
+    _statefulService->read(jsonObject, _stateReader);
+    _counters.persisted(ChecksumFile::checksum(jsonDocument, FS_PERSISTENCE_FORMAT));
+  }
+
+  // state the updater rejects is treated like missing state
+  bool updateFrom(JsonDocument& jsonDocument) {
+    if (!jsonDocument.is<JsonObject>()) {
+      return false;
+    }
+    JsonObject jsonObject = jsonDocument.as<JsonObject>();
+    return _statefulService->updateWithoutPropagation(jsonObject, _stateUpdater) != StateUpdateResult::ERROR;
+  }
+
+  static void writePending(void* context) {
+    static_cast<FSPersistence<T>*>(context)->writeToFS();
+  }
+
  protected:
   // We assume the updater supplies sensible defaults if an empty object
   // is supplied, this virtual function allows that to be changed.
   virtual void applyDefaults() {
-    DynamicJsonDocument jsonDocument = DynamicJsonDocument(_bufferSize);
+    PooledJsonDocument jsonDocument(_bufferSize);
     JsonObject jsonObject = jsonDocument.as<JsonObject>();
     _statefulService->updateWithoutPropagation(jsonObject, _stateUpdater);
   }
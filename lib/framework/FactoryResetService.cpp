@@ -10,7 +10,7 @@ FactoryResetService::FactoryResetService(AsyncWebServer* server, FS* fs, Securit
 }
 
 void FactoryResetService::handleRequest(AsyncWebServerRequest* request) {
-  request->onDisconnect(std::bind(&FactoryResetService::factoryReset, this));
+  AdmissionControl::onDisconnect(request, std::bind(&FactoryResetService::factoryReset, this));
   request->send(200);
 }
 
@@ -18,6 +18,9 @@ void FactoryResetService::handleRequest(AsyncWebServerRequest* request) {
  * Delete function assumes that all files are stored flat, within the config directory.
  */
 void FactoryResetService::factoryReset() {
+  // nothing may be written once the files are gone
+  WriteBehind::flushAll();
+  ConfigStore::resetAll();
 #ifdef ESP32
   File root = fs->open(FS_CONFIG_DIRECTORY);
   File file;
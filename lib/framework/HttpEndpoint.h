@@ -6,10 +6,37 @@
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
 
+#include <AdmissionControl.h>
+#include <JsonDocumentPool.h>
+#include <JsonUtils.h>
 #include <SecurityManager.h>
 #include <StatefulService.h>
 
 #define HTTP_ENDPOINT_ORIGIN_ID "http"
+#define HTTP_NOT_MODIFIED 304
+
+// GET responses from endpoints with buffers larger than this are serialized straight into the send buffer rather than
+// built in a string first
+#ifndef HTTP_ENDPOINT_STREAM_THRESHOLD
+#define HTTP_ENDPOINT_STREAM_THRESHOLD DEFAULT_BUFFER_SIZE
+#endif
+
+/**
+ * Propagates a change made by the request from the loop once the request has disconnected, or its deadline has passed.
+ * If the PropagationQueue is full the change propagates when the request disconnects.
+ *
+ * The endpoints' handlers run under an AdmissionControl hold, which owns the request's disconnect handler, so the
+ * callbacks are registered through AdmissionControl::onDisconnect() and run after the reservation is released.
+ */
+template <class T>
+void queueHttpPropagation(AsyncWebServerRequest* request, StatefulService<T>* statefulService) {
+  if (statefulService->queuePropagation(HTTP_ENDPOINT_ORIGIN_ID, request)) {
+    AdmissionControl::onDisconnect(request, [request]() { PropagationQueue::release(request); });
+  } else {
+    AdmissionControl::onDisconnect(
+        request, [statefulService]() { statefulService->callUpdateHandlers(HTTP_ENDPOINT_ORIGIN_ID); });
+  }
+}
 
 template <class T>
 class HttpGetEndpoint {
@@ -21,11 +48,16 @@ class HttpGetEndpoint {
                   SecurityManager* securityManager,
                   AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_ADMIN,
                   size_t bufferSize = DEFAULT_BUFFER_SIZE) :
-      _stateReader(stateReader), _statefulService(statefulService), _bufferSize(bufferSize) {
+      _stateReader(stateReader),
+      _statefulService(statefulService),
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
     server->on(servicePath.c_str(),
                HTTP_GET,
-               securityManager->wrapRequest(std::bind(&HttpGetEndpoint::fetchSettings, this, std::placeholders::_1),
-                                            authenticationPredicate));
+               AdmissionControl::wrapRequest(
+                   securityManager->wrapRequest(std::bind(&HttpGetEndpoint::fetchSettings, this, std::placeholders::_1),
+                                                authenticationPredicate),
+                   &_admission));
   }
 
   HttpGetEndpoint(JsonStateReader<T> stateReader,
@@ -33,23 +65,78 @@ class HttpGetEndpoint {
                   AsyncWebServer* server,
                   const String& servicePath,
                   size_t bufferSize = DEFAULT_BUFFER_SIZE) :
-      _stateReader(stateReader), _statefulService(statefulService), _bufferSize(bufferSize) {
-    server->on(servicePath.c_str(), HTTP_GET, std::bind(&HttpGetEndpoint::fetchSettings, this, std::placeholders::_1));
+      _stateReader(stateReader),
+      _statefulService(statefulService),
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
+    server->on(servicePath.c_str(),
+               HTTP_GET,
+               AdmissionControl::wrapRequest(std::bind(&HttpGetEndpoint::fetchSettings, this, std::placeholders::_1),
+                                             &_admission));
+  }
+
+  // requests are shed when the heap is low unless they have CONTROL priority, NORMAL by default
+  void setPriority(RequestPriority priority) {
+    _admission.priority = priority;
   }
 
  protected:
   JsonStateReader<T> _stateReader;
   StatefulService<T>* _statefulService;
   size_t _bufferSize;
+  AdmissionPolicy _admission;
+
+  // for endpoints which register their own handlers and respond with fetchSettings()
+  HttpGetEndpoint(JsonStateReader<T> stateReader, StatefulService<T>* statefulService, size_t bufferSize) :
+      _stateReader(stateReader),
+      _statefulService(statefulService),
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
+  }
+
+  static String revisionTag(uint32_t revision) {
+    return "\"" + String(revision, HEX) + "\"";
+  }
 
+  /**
+   * Responds with the state tagged with its revision, or with 304 if the client already holds that revision. The
+   * revision is taken before the state is read, so a concurrent update can only make the tag older than the body, which
+   * costs the client a refetch rather than leaving it with stale state.
+   *
+   * Large states are sent with an AsyncJsonResponse, which serializes its document into the send buffer, so the
+   * serialized state is not held in a string alongside the document.
+   */
   void fetchSettings(AsyncWebServerRequest* request) {
-    AsyncJsonResponse* response = new AsyncJsonResponse(false, _bufferSize);
-    JsonObject jsonObject = response->getRoot().to<JsonObject>();
-    _statefulService->read(jsonObject, _stateReader);
+    String etag = revisionTag(_statefulService->getRevision());
+    AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+    if (ifNoneMatch && (ifNoneMatch->value().indexOf(etag) >= 0 || ifNoneMatch->value() == "*")) {
+      AsyncWebServerResponse* response = request->beginResponse(HTTP_NOT_MODIFIED);
+      addCacheHeaders(response, etag);
+      request->send(response);
+      return;
+    }
 
-    response->setLength();
+    AsyncWebServerResponse* response;
+    if (_bufferSize > HTTP_ENDPOINT_STREAM_THRESHOLD) {
+      AsyncJsonResponse* jsonResponse = new AsyncJsonResponse(false, _bufferSize);
+      JsonObject jsonObject = jsonResponse->getRoot().to<JsonObject>();
+      _statefulService->read(jsonObject, _stateReader);
+      jsonResponse->setLength();
+      response = jsonResponse;
+    } else {
+      String payload;
+      _statefulService->serialize(_stateReader, payload, _bufferSize);
+      response = request->beginResponse(200, JSON_MIMETYPE, payload);
+    }
+    addCacheHeaders(response, etag);
     request->send(response);
   }
+
+  // clients may keep the response but must revalidate it before each use
+  static void addCacheHeaders(AsyncWebServerResponse* response, const String& etag) {
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+  }
 };
 
 template <class T>
@@ -68,11 +155,14 @@ class HttpPostEndpoint {
       _statefulService(statefulService),
       _updateHandler(
           servicePath,
-          securityManager->wrapCallback(
-              std::bind(&HttpPostEndpoint::updateSettings, this, std::placeholders::_1, std::placeholders::_2),
-              authenticationPredicate),
+          AdmissionControl::wrapCallback(
+              securityManager->wrapCallback(
+                  std::bind(&HttpPostEndpoint::updateSettings, this, std::placeholders::_1, std::placeholders::_2),
+                  authenticationPredicate),
+              &_admission),
           bufferSize),
-      _bufferSize(bufferSize) {
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
     _updateHandler.setMethod(HTTP_POST);
     server->addHandler(&_updateHandler);
   }
@@ -86,20 +176,29 @@ class HttpPostEndpoint {
       _stateReader(stateReader),
       _stateUpdater(stateUpdater),
       _statefulService(statefulService),
-      _updateHandler(servicePath,
-                     std::bind(&HttpPostEndpoint::updateSettings, this, std::placeholders::_1, std::placeholders::_2),
-                     bufferSize),
-      _bufferSize(bufferSize) {
+      _updateHandler(
+          servicePath,
+          AdmissionControl::wrapCallback(
+              std::bind(&HttpPostEndpoint::updateSettings, this, std::placeholders::_1, std::placeholders::_2),
+              &_admission),
+          bufferSize),
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
     _updateHandler.setMethod(HTTP_POST);
     server->addHandler(&_updateHandler);
   }
 
+  void setPriority(RequestPriority priority) {
+    _admission.priority = priority;
+  }
+
  protected:
   JsonStateReader<T> _stateReader;
   JsonStateUpdater<T> _stateUpdater;
   StatefulService<T>* _statefulService;
   AsyncCallbackJsonWebHandler _updateHandler;
   size_t _bufferSize;
+  AdmissionPolicy _admission;
 
   void updateSettings(AsyncWebServerRequest* request, JsonVariant& json) {
     if (!json.is<JsonObject>()) {
@@ -113,18 +212,111 @@ class HttpPostEndpoint {
       return;
     }
     if (outcome == StateUpdateResult::CHANGED) {
-      request->onDisconnect([this]() { _statefulService->callUpdateHandlers(HTTP_ENDPOINT_ORIGIN_ID); });
+      queueHttpPropagation(request, _statefulService);
     }
-    AsyncJsonResponse* response = new AsyncJsonResponse(false, _bufferSize);
-    jsonObject = response->getRoot().to<JsonObject>();
-    _statefulService->read(jsonObject, _stateReader);
-    response->setLength();
-    request->send(response);
+    String payload;
+    _statefulService->serialize(_stateReader, payload, _bufferSize);
+    request->send(200, JSON_MIMETYPE, payload);
+  }
+};
+
+/**
+ * Applies a JSON merge patch (RFC 7386) to the state, so a client changing one field sends only that field. The patch
+ * is merged into the current state as read by the state reader and the result is passed to the state updater, all under
+ * the service's access mutex so concurrent updates are not lost. Members set to null are removed before the updater
+ * runs, which resets them to their defaults.
+ *
+ * The request must have the "application/json" content type.
+ */
+template <class T>
+class HttpPatchEndpoint {
+ public:
+  HttpPatchEndpoint(JsonStateReader<T> stateReader,
+                    JsonStateUpdater<T> stateUpdater,
+                    StatefulService<T>* statefulService,
+                    AsyncWebServer* server,
+                    const String& servicePath,
+                    SecurityManager* securityManager,
+                    AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_ADMIN,
+                    size_t bufferSize = DEFAULT_BUFFER_SIZE) :
+      _stateReader(stateReader),
+      _stateUpdater(stateUpdater),
+      _statefulService(statefulService),
+      _patchHandler(
+          servicePath,
+          AdmissionControl::wrapCallback(
+              securityManager->wrapCallback(
+                  std::bind(&HttpPatchEndpoint::patchSettings, this, std::placeholders::_1, std::placeholders::_2),
+                  authenticationPredicate),
+              &_admission),
+          bufferSize),
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
+    _patchHandler.setMethod(HTTP_PATCH);
+    server->addHandler(&_patchHandler);
+  }
+
+  HttpPatchEndpoint(JsonStateReader<T> stateReader,
+                    JsonStateUpdater<T> stateUpdater,
+                    StatefulService<T>* statefulService,
+                    AsyncWebServer* server,
+                    const String& servicePath,
+                    size_t bufferSize = DEFAULT_BUFFER_SIZE) :
+      _stateReader(stateReader),
+      _stateUpdater(stateUpdater),
+      _statefulService(statefulService),
+      _patchHandler(
+          servicePath,
+          AdmissionControl::wrapCallback(
+              std::bind(&HttpPatchEndpoint::patchSettings, this, std::placeholders::_1, std::placeholders::_2),
+              &_admission),
+          bufferSize),
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
+    _patchHandler.setMethod(HTTP_PATCH);
+    server->addHandler(&_patchHandler);
+  }
+
+  void setPriority(RequestPriority priority) {
+    _admission.priority = priority;
+  }
+
+ protected:
+  JsonStateReader<T> _stateReader;
+  JsonStateUpdater<T> _stateUpdater;
+  StatefulService<T>* _statefulService;
+  AsyncCallbackJsonWebHandler _patchHandler;
+  size_t _bufferSize;
+  AdmissionPolicy _admission;
+
+  void patchSettings(AsyncWebServerRequest* request, JsonVariant& json) {
+    if (!json.is<JsonObject>()) {
+      request->send(400);
+      return;
+    }
+    JsonObject patch = json.as<JsonObject>();
+    StateUpdateResult outcome = _statefulService->updateWithoutPropagation([&](T& state) {
+      PooledJsonDocument jsonDocument(_bufferSize);
+      JsonObject merged = jsonDocument.to<JsonObject>();
+      _stateReader(state, merged);
+      JsonUtils::mergePatch(merged, patch);
+      return _stateUpdater(merged, state);
+    });
+    if (outcome == StateUpdateResult::ERROR) {
+      request->send(400);
+      return;
+    }
+    if (outcome == StateUpdateResult::CHANGED) {
+      queueHttpPropagation(request, _statefulService);
+    }
+    String payload;
+    _statefulService->serialize(_stateReader, payload, _bufferSize);
+    request->send(200, JSON_MIMETYPE, payload);
   }
 };
 
 template <class T>
-class HttpEndpoint : public HttpGetEndpoint<T>, public HttpPostEndpoint<T> {
+class HttpEndpoint : public HttpGetEndpoint<T>, public HttpPostEndpoint<T>, public HttpPatchEndpoint<T> {
  public:
   HttpEndpoint(JsonStateReader<T> stateReader,
                JsonStateUpdater<T> stateUpdater,
@@ -148,7 +340,15 @@ class HttpEndpoint : public HttpGetEndpoint<T>, public HttpPostEndpoint<T> {
                           servicePath,
                           securityManager,
                           authenticationPredicate,
-                          bufferSize) {
+                          bufferSize),
+      HttpPatchEndpoint<T>(stateReader,
+                           stateUpdater,
+                           statefulService,
+                           server,
+                           servicePath,
+                           securityManager,
+                           authenticationPredicate,
+                           bufferSize) {
   }
 
   HttpEndpoint(JsonStateReader<T> stateReader,
@@ -158,7 +358,15 @@ class HttpEndpoint : public HttpGetEndpoint<T>, public HttpPostEndpoint<T> {
                const String& servicePath,
                size_t bufferSize = DEFAULT_BUFFER_SIZE) :
       HttpGetEndpoint<T>(stateReader, statefulService, server, servicePath, bufferSize),
-      HttpPostEndpoint<T>(stateReader, stateUpdater, statefulService, server, servicePath, bufferSize) {
+      HttpPostEndpoint<T>(stateReader, stateUpdater, statefulService, server, servicePath, bufferSize),
+      HttpPatchEndpoint<T>(stateReader, stateUpdater, statefulService, server, servicePath, bufferSize) {
+  }
+
+  // sets the priority of GET, POST and PATCH requests
+  void setPriority(RequestPriority priority) {
+    HttpGetEndpoint<T>::setPriority(priority);
+    HttpPostEndpoint<T>::setPriority(priority);
+    HttpPatchEndpoint<T>::setPriority(priority);
   }
 };
 
@@ -0,0 +1,67 @@
+#include <JsonDocumentPool.h>
+
+#ifdef ESP32
+static portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+#define POOL_LOCK() portENTER_CRITICAL(&poolMux)
+#define POOL_UNLOCK() portEXIT_CRITICAL(&poolMux)
+#else
+#define POOL_LOCK()
+#define POOL_UNLOCK()
+#endif
+
+alignas(8) static uint8_t slabs[JSON_DOCUMENT_POOL_SLABS][JSON_DOCUMENT_POOL_SLAB_SIZE];
+static bool slabInUse[JSON_DOCUMENT_POOL_SLABS];
+
+uint32_t JsonDocumentPool::_hits = 0;
+uint32_t JsonDocumentPool::_misses = 0;
+
+void* JsonDocumentPool::allocate(size_t size) {
+  POOL_LOCK();
+  for (uint8_t i = 0; i < JSON_DOCUMENT_POOL_SLABS && size <= JSON_DOCUMENT_POOL_SLAB_SIZE; i++) {
+    if (!slabInUse[i]) {
+      slabInUse[i] = true;
+      _hits++;
+      POOL_UNLOCK();
+      return slabs[i];
+    }
+  }
+  _misses++;
+  POOL_UNLOCK();
+  return malloc(size);
+}
+
+void JsonDocumentPool::deallocate(void* pointer) {
+  int8_t index = slabIndex(pointer);
+  if (index < 0) {
+    free(pointer);
+    return;
+  }
+  POOL_LOCK();
+  slabInUse[index] = false;
+  POOL_UNLOCK();
+}
+
+void* JsonDocumentPool::reallocate(void* pointer, size_t size) {
+  int8_t index = slabIndex(pointer);
+  if (index < 0) {
+    return realloc(pointer, size);
+  }
+  if (size <= JSON_DOCUMENT_POOL_SLAB_SIZE) {
+    return pointer;
+  }
+  // outgrown the slab, move to the heap
+  void* moved = malloc(size);
+  if (moved) {
+    memcpy(moved, pointer, JSON_DOCUMENT_POOL_SLAB_SIZE);
+    deallocate(pointer);
+  }
+  return moved;
+}
+
+int8_t JsonDocumentPool::slabIndex(void* pointer) {
+  uint8_t* address = static_cast<uint8_t*>(pointer);
+  if (address < slabs[0] || address >= slabs[0] + sizeof(slabs)) {
+    return -1;
+  }
+  return (address - slabs[0]) / JSON_DOCUMENT_POOL_SLAB_SIZE;
+}
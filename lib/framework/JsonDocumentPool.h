@@ -0,0 +1,59 @@
+#ifndef JsonDocumentPool_h
+#define JsonDocumentPool_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef JSON_DOCUMENT_POOL_SLABS
+#define JSON_DOCUMENT_POOL_SLABS 3
+#endif
+
+#ifndef JSON_DOCUMENT_POOL_SLAB_SIZE
+#define JSON_DOCUMENT_POOL_SLAB_SIZE 1024
+#endif
+
+/**
+ * A few statically allocated slabs which the framework's JSON documents borrow in place of the heap, so the documents
+ * built for each request, message and file write no longer leave holes in the heap as they come and go.
+ *
+ * Documents no larger than JSON_DOCUMENT_POOL_SLAB_SIZE take the first free slab and are counted as hits. Larger
+ * documents, and documents created while every slab is in use, fall back to the heap and are counted as misses.
+ */
+class JsonDocumentPool {
+ public:
+  static void* allocate(size_t size);
+  static void deallocate(void* pointer);
+  static void* reallocate(void* pointer, size_t size);
+
+  static uint32_t getHits() {
+    return _hits;
+  }
+
+  static uint32_t getMisses() {
+    return _misses;
+  }
+
+ private:
+  static uint32_t _hits;
+  static uint32_t _misses;
+
+  static int8_t slabIndex(void* pointer);
+};
+
+struct PooledJsonAllocator {
+  void* allocate(size_t size) {
+    return JsonDocumentPool::allocate(size);
+  }
+
+  void deallocate(void* pointer) {
+    JsonDocumentPool::deallocate(pointer);
+  }
+
+  void* reallocate(void* pointer, size_t size) {
+    return JsonDocumentPool::reallocate(pointer, size);
+  }
+};
+
+typedef BasicJsonDocument<PooledJsonAllocator> PooledJsonDocument;
+
+#endif  // end JsonDocumentPool_h
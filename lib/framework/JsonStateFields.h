@@ -0,0 +1,241 @@
+#ifndef JsonStateFields_h
+#define JsonStateFields_h
+
+#include <StatefulService.h>
+
+#include <string.h>
+
+/**
+ * Generates the JSON reader and updater for a state class from a list of field descriptors, along with an upper bound
+ * on the capacity of a JsonDocument holding the state, so endpoints and persistence can size their documents exactly
+ * rather than relying on DEFAULT_BUFFER_SIZE.
+ *
+ * Each descriptor maps a member to a JSON key and a default, which the updater applies when the key is missing. String
+ * members also have a maximum length, updates holding longer strings are rejected so the capacity holds. Persistence
+ * loads the state with load() instead, which cuts stored strings down to their maximum length rather than rejecting
+ * the whole state, so settings saved before a limit was introduced or lowered still load:
+ *
+ * JSON_STATE_FIELD(OTAEnabledField, OTASettings, enabled, "enabled", FACTORY_OTA_ENABLED);
+ * JSON_STATE_STRING_FIELD(OTAPasswordField, OTASettings, password, "password", FACTORY_OTA_PASSWORD, 64);
+ * typedef JsonStateFields<OTASettings, OTAEnabledField, OTAPasswordField> OTASettingsFields;
+ *
+ * FSPersistence<OTASettings> fsPersistence(OTASettingsFields::read, OTASettingsFields::load, ...);
+ *
+ * The generated updater validates every field before changing any of them and only reports CHANGED if a field changed.
+ * Fields are assigned bits in the order they are listed, for state classes derived from TrackedState the updater marks
+ * the fields it changed and readFields() serves as the JsonStateFieldReader.
+ */
+
+#define JSON_STATE_FIELD(Name, State, Member, Key, Default)                                 \
+  struct Name : JsonStateValueField<Name, State, decltype(State::Member), &State::Member> { \
+    static_assert(!std::is_same<decltype(State::Member), String>::value,                    \
+                  "String members are declared with JSON_STATE_STRING_FIELD");              \
+    static const char* key() {                                                              \
+      return Key;                                                                           \
+    }                                                                                       \
+    static constexpr size_t keyCapacity() {                                                 \
+      return sizeof(Key);                                                                   \
+    }                                                                                       \
+    static decltype(State::Member) defaultValue() {                                         \
+      return Default;                                                                       \
+    }                                                                                       \
+  }
+
+#define JSON_STATE_STRING_FIELD(Name, State, Member, Key, Default, MaxLength)  \
+  struct Name : JsonStateStringField<Name, State, &State::Member, MaxLength> { \
+    static const char* key() {                                                 \
+      return Key;                                                              \
+    }                                                                          \
+    static constexpr size_t keyCapacity() {                                    \
+      return sizeof(Key);                                                      \
+    }                                                                          \
+    static String defaultValue() {                                             \
+      return Default;                                                          \
+    }                                                                          \
+  }
+
+template <class Field, class T, class V, V T::*Member>
+class JsonStateValueField {
+ public:
+  static constexpr size_t capacity() {
+    return Field::keyCapacity();
+  }
+
+  static void read(T& state, JsonObject& root) {
+    root[Field::key()] = state.*Member;
+  }
+
+  static bool valid(JsonObject& root) {
+    return true;
+  }
+
+  static bool update(JsonObject& root, T& state) {
+    V value = root[Field::key()] | Field::defaultValue();
+    return assign(state, value);
+  }
+
+  static bool load(JsonObject& root, T& state) {
+    return Field::update(root, state);
+  }
+
+ protected:
+  static bool assign(T& state, const V& value) {
+    if (state.*Member == value) {
+      return false;
+    }
+    state.*Member = value;
+    return true;
+  }
+};
+
+template <class Field, class T, String T::*Member, size_t MaxLength>
+class JsonStateStringField : public JsonStateValueField<Field, T, String, Member> {
+ public:
+  // strings are copied into the document
+  static constexpr size_t capacity() {
+    return Field::keyCapacity() + MaxLength + 1;
+  }
+
+  static bool valid(JsonObject& root) {
+    JsonVariant value = root[Field::key()];
+    return !value.is<const char*>() || strlen(value.as<const char*>()) <= MaxLength;
+  }
+
+  // a longer string is cut at the last character boundary within MaxLength
+  static bool load(JsonObject& root, T& state) {
+    String value = root[Field::key()] | Field::defaultValue();
+    if (value.length() > MaxLength) {
+      size_t length = MaxLength;
+      while (length && (value[length] & 0xC0) == 0x80) {
+        length--;
+      }
+      value.remove(length);
+    }
+    return JsonStateValueField<Field, T, String, Member>::assign(state, value);
+  }
+};
+
+template <class T, uint8_t Index, class... Fields>
+class JsonStateFieldList {
+ public:
+  static constexpr size_t capacity() {
+    return 0;
+  }
+
+  template <class Field>
+  static constexpr state_field_mask_t fieldMask() {
+    return 0;
+  }
+
+  static void read(T& state, JsonObject& root, state_field_mask_t fields) {
+  }
+
+  static bool valid(JsonObject& root) {
+    return true;
+  }
+
+  static void update(JsonObject& root, T& state, state_field_mask_t& changedFields) {
+  }
+
+  static void load(JsonObject& root, T& state, state_field_mask_t& changedFields) {
+  }
+};
+
+template <class T, uint8_t Index, class Field, class... Fields>
+class JsonStateFieldList<T, Index, Field, Fields...> {
+  typedef JsonStateFieldList<T, Index + 1, Fields...> Next;
+
+ public:
+  static constexpr size_t capacity() {
+    return Field::capacity() + Next::capacity();
+  }
+
+  template <class F>
+  static constexpr state_field_mask_t fieldMask() {
+    return std::is_same<F, Field>::value ? (state_field_mask_t)1 << Index : Next::template fieldMask<F>();
+  }
+
+  static void read(T& state, JsonObject& root, state_field_mask_t fields) {
+    if (fields & ((state_field_mask_t)1 << Index)) {
+      Field::read(state, root);
+    }
+    Next::read(state, root, fields);
+  }
+
+  static bool valid(JsonObject& root) {
+    return Field::valid(root) && Next::valid(root);
+  }
+
+  static void update(JsonObject& root, T& state, state_field_mask_t& changedFields) {
+    if (Field::update(root, state)) {
+      changedFields |= (state_field_mask_t)1 << Index;
+    }
+    Next::update(root, state, changedFields);
+  }
+
+  static void load(JsonObject& root, T& state, state_field_mask_t& changedFields) {
+    if (Field::load(root, state)) {
+      changedFields |= (state_field_mask_t)1 << Index;
+    }
+    Next::load(root, state, changedFields);
+  }
+};
+
+template <class T, class... Fields>
+class JsonStateFields {
+  static_assert(sizeof...(Fields) <= sizeof(state_field_mask_t) * 8, "Too many fields for a state_field_mask_t");
+
+  typedef JsonStateFieldList<T, 0, Fields...> List;
+
+ public:
+  static constexpr size_t capacity() {
+    return JSON_OBJECT_SIZE(sizeof...(Fields)) + List::capacity();
+  }
+
+  template <class Field>
+  static constexpr state_field_mask_t field() {
+    return List::template fieldMask<Field>();
+  }
+
+  static void read(T& state, JsonObject& root) {
+    List::read(state, root, ALL_STATE_FIELDS);
+  }
+
+  static void readFields(T& state, JsonObject& root, state_field_mask_t fields) {
+    List::read(state, root, fields);
+  }
+
+  static StateUpdateResult update(JsonObject& root, T& state) {
+    if (!List::valid(root)) {
+      return StateUpdateResult::ERROR;
+    }
+    state_field_mask_t changedFields = 0;
+    List::update(root, state, changedFields);
+    return changed(state, changedFields);
+  }
+
+  // the updater for stored state, which is never rejected
+  static StateUpdateResult load(JsonObject& root, T& state) {
+    state_field_mask_t changedFields = 0;
+    List::load(root, state, changedFields);
+    return changed(state, changedFields);
+  }
+
+ private:
+  static StateUpdateResult changed(T& state, state_field_mask_t changedFields) {
+    if (!changedFields) {
+      return StateUpdateResult::UNCHANGED;
+    }
+    markChanged(state, changedFields, std::is_base_of<TrackedState, T>());
+    return StateUpdateResult::CHANGED;
+  }
+
+  static void markChanged(T& state, state_field_mask_t changedFields, std::false_type) {
+  }
+
+  static void markChanged(T& state, state_field_mask_t changedFields, std::true_type) {
+    state.markChanged(changedFields);
+  }
+};
+
+#endif  // end JsonStateFields_h
@@ -24,6 +24,62 @@ class JsonUtils {
       root[key] = ip.toString();
     }
   }
+
+  /**
+   * Applies a JSON merge patch (RFC 7386) to the target: members set to null are removed, objects are merged member by
+   * member and any other value, including an array, replaces the target's value.
+   */
+  static void mergePatch(JsonObject& target, JsonObject& patch) {
+    for (JsonPair member : patch) {
+      JsonString key = member.key();
+      JsonVariant value = member.value();
+      if (value.isNull()) {
+        target.remove(key.c_str());
+      } else if (value.is<JsonObject>()) {
+        JsonVariant existing = target[key.c_str()];
+        JsonObject child =
+            existing.is<JsonObject>() ? existing.as<JsonObject>() : target.createNestedObject(key.c_str());
+        JsonObject childPatch = value.as<JsonObject>();
+        mergePatch(child, childPatch);
+      } else {
+        target[key.c_str()] = value;
+      }
+    }
+  }
+
+  /**
+   * Turns to into the JSON merge patch (RFC 7386) from from, in place: members equal in both are removed, objects are
+   * compared member by member and members missing from to are added as null. The added members are named with from's
+   * keys, so from must be kept until the patch has been serialized. Returns false if to had no room for a member, the
+   * patch is then incomplete.
+   */
+  static bool diff(JsonObject& from, JsonObject& to) {
+    for (JsonPair member : from) {
+      JsonString key = member.key();
+      JsonVariant previous = member.value();
+      if (!to.containsKey(key.c_str())) {
+        to[key.c_str()] = (const char*)nullptr;
+        if (!to.containsKey(key.c_str())) {
+          return false;
+        }
+        continue;
+      }
+      JsonVariant value = to[key.c_str()];
+      if (value.is<JsonObject>() && previous.is<JsonObject>()) {
+        JsonObject fromChild = previous.as<JsonObject>();
+        JsonObject toChild = value.as<JsonObject>();
+        if (!diff(fromChild, toChild)) {
+          return false;
+        }
+        if (!toChild.size()) {
+          to.remove(key.c_str());
+        }
+      } else if (value == previous) {
+        to.remove(key.c_str());
+      }
+    }
+    return true;
+  }
 };
 
 #endif  // end JsonUtils
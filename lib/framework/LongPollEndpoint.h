@@ -0,0 +1,155 @@
+#ifndef LongPollEndpoint_h
+#define LongPollEndpoint_h
+
+#include <HttpEndpoint.h>
+
+#define LONG_POLL_TIMEOUT_PARAMETER "timeout"
+
+// requests held at once by each endpoint, further requests are answered with 503
+#ifndef LONG_POLL_MAX_PENDING
+#define LONG_POLL_MAX_PENDING 4
+#endif
+
+// seconds a request is held for if it does not give a timeout
+#ifndef LONG_POLL_DEFAULT_TIMEOUT
+#define LONG_POLL_DEFAULT_TIMEOUT 20
+#endif
+
+#ifndef LONG_POLL_MAX_TIMEOUT
+#define LONG_POLL_MAX_TIMEOUT 60
+#endif
+
+/**
+ * A change feed for clients which can not hold a WebSocket. A GET carrying the ETag of the state the client holds in
+ * If-None-Match is held until the service's revision moves past it, then answered with the new state and its ETag. If
+ * the revision has not moved within the timeout, given in seconds by the timeout parameter, it is answered with 304 Not
+ * Modified. Requests without a current ETag are answered at once, like a GET of the HttpEndpoint:
+ *
+ * curl -H 'If-None-Match: "5f3a2c1b"' http://device/rest/poll/lightState?timeout=30
+ *
+ * A held request is answered by its response, which the web server polls from its own task about twice a second until
+ * the revision moves or the timeout passes, so the state is read and sent as it would be for any other request.
+ * Admission control applies when a request arrives, a held request is always answered.
+ */
+template <class T>
+class LongPollEndpoint : public HttpGetEndpoint<T> {
+ public:
+  LongPollEndpoint(JsonStateReader<T> stateReader,
+                   StatefulService<T>* statefulService,
+                   AsyncWebServer* server,
+                   const String& pollPath,
+                   SecurityManager* securityManager,
+                   AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_ADMIN,
+                   size_t bufferSize = DEFAULT_BUFFER_SIZE) :
+      HttpGetEndpoint<T>(stateReader, statefulService, bufferSize), _pendingCount(0) {
+    server->on(pollPath.c_str(),
+               HTTP_GET,
+               AdmissionControl::wrapRequest(
+                   securityManager->wrapRequest(std::bind(&LongPollEndpoint::poll, this, std::placeholders::_1),
+                                                authenticationPredicate),
+                   &this->_admission));
+  }
+
+  LongPollEndpoint(JsonStateReader<T> stateReader,
+                   StatefulService<T>* statefulService,
+                   AsyncWebServer* server,
+                   const String& pollPath,
+                   size_t bufferSize = DEFAULT_BUFFER_SIZE) :
+      HttpGetEndpoint<T>(stateReader, statefulService, bufferSize), _pendingCount(0) {
+    server->on(pollPath.c_str(),
+               HTTP_GET,
+               AdmissionControl::wrapRequest(std::bind(&LongPollEndpoint::poll, this, std::placeholders::_1),
+                                             &this->_admission));
+  }
+
+ private:
+  /**
+   * Sent as soon as the request is held, it waits to be acknowledged by the web server's poll of the connection until
+   * the revision moves or the timeout passes. It then takes the status, headers and content it answers with, which the
+   * device library only sends once the response has been started.
+   */
+  class HeldResponse : public AsyncAbstractResponse {
+   public:
+    HeldResponse(LongPollEndpoint* endpoint, uint32_t revision, uint32_t timeout) :
+        _endpoint(endpoint), _revision(revision), _heldAt(millis()), _timeout(timeout), _answered(false), _index(0) {
+      _endpoint->_pendingCount++;
+    }
+
+    // the request is freed with its response once the client disconnects, which it may do before it is answered
+    ~HeldResponse() {
+      _endpoint->_pendingCount--;
+    }
+
+    bool _sourceValid() const {
+      return true;
+    }
+
+    void _respond(AsyncWebServerRequest* request) {
+      _ack(request, 0, 0);
+    }
+
+    size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) {
+      if (_answered) {
+        return AsyncAbstractResponse::_ack(request, len, time);
+      }
+      uint32_t revision = _endpoint->_statefulService->getRevision();
+      if (revision == _revision && (uint32_t)(millis() - _heldAt) < _timeout) {
+        return 0;
+      }
+      _answered = true;
+      if (revision == _revision) {
+        setCode(HTTP_NOT_MODIFIED);
+      } else {
+        _endpoint->_statefulService->serialize(_endpoint->_stateReader, _payload, _endpoint->_bufferSize);
+        setContentType(JSON_MIMETYPE);
+      }
+      setContentLength(_payload.length());
+      HttpGetEndpoint<T>::addCacheHeaders(this, HttpGetEndpoint<T>::revisionTag(revision));
+      AsyncAbstractResponse::_respond(request);
+      return 0;
+    }
+
+    size_t _fillBuffer(uint8_t* buf, size_t maxLen) {
+      size_t len = _payload.length() - _index < maxLen ? _payload.length() - _index : maxLen;
+      memcpy(buf, _payload.c_str() + _index, len);
+      _index += len;
+      return len;
+    }
+
+   private:
+    LongPollEndpoint* _endpoint;
+    uint32_t _revision;
+    uint32_t _heldAt;
+    uint32_t _timeout;
+    bool _answered;
+    String _payload;
+    size_t _index;
+  };
+
+  // only changed from the web server's callbacks, which run in turn
+  uint8_t _pendingCount;
+
+  void poll(AsyncWebServerRequest* request) {
+    uint32_t revision = this->_statefulService->getRevision();
+    AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+    if (!ifNoneMatch || ifNoneMatch->value().indexOf(this->revisionTag(revision)) < 0) {
+      this->fetchSettings(request);
+      return;
+    }
+
+    uint32_t timeout = LONG_POLL_DEFAULT_TIMEOUT;
+    AsyncWebParameter* timeoutParameter = request->getParam(LONG_POLL_TIMEOUT_PARAMETER);
+    if (timeoutParameter) {
+      long requested = timeoutParameter->value().toInt();
+      timeout = requested < 0 ? 0 : requested > LONG_POLL_MAX_TIMEOUT ? LONG_POLL_MAX_TIMEOUT : requested;
+    }
+
+    if (_pendingCount == LONG_POLL_MAX_PENDING) {
+      request->send(503);
+      return;
+    }
+    request->send(new HeldResponse(this, revision, timeout * 1000));
+  }
+};
+
+#endif  // end LongPollEndpoint_h
@@ -0,0 +1,49 @@
+#include <LoopHook.h>
+
+#include <stddef.h>
+
+LoopHook* LoopHook::_first = nullptr;
+
+LoopHook::LoopHook(LoopFunction loopFunction, void* context) :
+    _loopFunction(loopFunction), _context(context), _next(nullptr), _attached(false) {
+}
+
+LoopHook::~LoopHook() {
+  detach();
+}
+
+void LoopHook::attach() {
+  if (_attached) {
+    return;
+  }
+  LoopHook** last = &_first;
+  while (*last) {
+    last = &(*last)->_next;
+  }
+  *last = this;
+  _next = nullptr;
+  _attached = true;
+}
+
+void LoopHook::detach() {
+  if (!_attached) {
+    return;
+  }
+  for (LoopHook** hook = &_first; *hook; hook = &(*hook)->_next) {
+    if (*hook == this) {
+      *hook = _next;
+      break;
+    }
+  }
+  _next = nullptr;
+  _attached = false;
+}
+
+void LoopHook::loopAll() {
+  for (LoopHook* hook = _first; hook;) {
+    // hooks may detach themselves
+    LoopHook* next = hook->_next;
+    hook->_loopFunction(hook->_context);
+    hook = next;
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef LoopHook_h
+#define LoopHook_h
+
+/**
+ * Lets framework components defer work to the main loop without ESP8266React having to know about them.
+ *
+ * Attached hooks are kept in an intrusive list, so attaching one never allocates, and are called in the order they
+ * were attached each time ESP8266React::loop() runs.
+ */
+class LoopHook {
+ public:
+  typedef void (*LoopFunction)(void* context);
+
+  LoopHook(LoopFunction loopFunction, void* context);
+  ~LoopHook();
+
+  // a copy would point at the owner of the original and claim a place in the list it does not have
+  LoopHook(const LoopHook&) = delete;
+  LoopHook& operator=(const LoopHook&) = delete;
+
+  void attach();
+  void detach();
+
+  bool isAttached() const {
+    return _attached;
+  }
+
+  static void loopAll();
+
+ private:
+  static LoopHook* _first;
+
+  LoopFunction _loopFunction;
+  void* _context;
+  LoopHook* _next;
+  bool _attached;
+};
+
+#endif  // end LoopHook_h
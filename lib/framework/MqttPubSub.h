@@ -29,13 +29,21 @@ class MqttConnector {
 template <class T>
 class MqttPub : virtual public MqttConnector<T> {
  public:
+  // the update handlers registered on the service, for sizing its handler table
+  static const uint8_t updateHandlerCount = 1;
+
   MqttPub(JsonStateReader<T> stateReader,
           StatefulService<T>* statefulService,
           AsyncMqttClient* mqttClient,
           const String& pubTopic = "",
           size_t bufferSize = DEFAULT_BUFFER_SIZE) :
       MqttConnector<T>(statefulService, mqttClient, bufferSize), _stateReader(stateReader), _pubTopic(pubTopic) {
-    MqttConnector<T>::_statefulService->addUpdateHandler([&](const String& originId) { publish(); }, false);
+    MqttConnector<T>::_statefulService->addUpdateHandler(
+        [](void* context, const String& originId, state_field_mask_t changedFields) {
+          static_cast<MqttPub<T>*>(context)->publish(changedFields);
+        },
+        this,
+        false);
   }
 
   void setPubTopic(const String& pubTopic) {
@@ -43,6 +51,14 @@ class MqttPub : virtual public MqttConnector<T> {
     publish();
   }
 
+  /**
+   * Sets a reader used to publish only the fields changed by an update, for state types derived from TrackedState.
+   * The full state is published when all fields have changed and when the client connects.
+   */
+  void setFieldReader(JsonStateFieldReader<T> fieldReader) {
+    _fieldReader = fieldReader;
+  }
+
  protected:
   virtual void onConnect() {
     publish();
@@ -50,17 +66,30 @@ class MqttPub : virtual public MqttConnector<T> {
 
  private:
   JsonStateReader<T> _stateReader;
+  JsonStateFieldReader<T> _fieldReader;
   String _pubTopic;
 
-  void publish() {
+  void publish(state_field_mask_t changedFields = ALL_STATE_FIELDS) {
     if (_pubTopic.length() > 0 && MqttConnector<T>::_mqttClient->connected()) {
+      // reuse the payload serialized for another endpoint if the state has not changed since
+      String payload;
+      if (changedFields == ALL_STATE_FIELDS || !_fieldReader) {
+        if (MqttConnector<T>::_statefulService->readPayload(_stateReader, payload, MqttConnector<T>::_bufferSize)) {
+          MqttConnector<T>::_mqttClient->publish(_pubTopic.c_str(), 0, false, payload.c_str());
+          return;
+        }
+      }
+
       // serialize to json doc
-      DynamicJsonDocument json(MqttConnector<T>::_bufferSize);
+      PooledJsonDocument json(MqttConnector<T>::_bufferSize);
       JsonObject jsonObject = json.to<JsonObject>();
-      MqttConnector<T>::_statefulService->read(jsonObject, _stateReader);
+      if (_fieldReader && changedFields != ALL_STATE_FIELDS) {
+        MqttConnector<T>::_statefulService->readFields(jsonObject, _fieldReader, changedFields);
+      } else {
+        MqttConnector<T>::_statefulService->read(jsonObject, _stateReader);
+      }
 
       // serialize to string
-      String payload;
       serializeJson(json, payload);
 
       // publish the payload
@@ -127,7 +156,7 @@ class MqttSub : virtual public MqttConnector<T> {
     }
 
     // deserialize from string
-    DynamicJsonDocument json(MqttConnector<T>::_bufferSize);
+    PooledJsonDocument json(MqttConnector<T>::_bufferSize);
     DeserializationError error = deserializeJson(json, payload, len);
     if (!error && json.is<JsonObject>()) {
       JsonObject jsonObject = json.as<JsonObject>();
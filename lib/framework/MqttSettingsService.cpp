@@ -29,6 +29,7 @@ MqttSettingsService::MqttSettingsService(AsyncWebServer* server, FS* fs, Securit
     _retainedPassword(nullptr),
     _reconfigureMqtt(false),
     _disconnectedAt(0),
+    _loaded(false),
     _disconnectReason(AsyncMqttClientDisconnectReason::TCP_DISCONNECTED),
     _mqttClient() {
 #ifdef ESP32
@@ -45,7 +46,12 @@ MqttSettingsService::MqttSettingsService(AsyncWebServer* server, FS* fs, Securit
 #endif
   _mqttClient.onConnect(std::bind(&MqttSettingsService::onMqttConnect, this, std::placeholders::_1));
   _mqttClient.onDisconnect(std::bind(&MqttSettingsService::onMqttDisconnect, this, std::placeholders::_1));
-  addUpdateHandler([&](const String& originId) { onConfigUpdated(); }, false);
+  addUpdateHandler(
+      [](void* context, const String& originId, state_field_mask_t changedFields) {
+        static_cast<MqttSettingsService*>(context)->onConfigUpdated();
+      },
+      this,
+      false);
 }
 
 MqttSettingsService::~MqttSettingsService() {
@@ -53,6 +59,9 @@ MqttSettingsService::~MqttSettingsService() {
 
 void MqttSettingsService::begin() {
   _fsPersistence.readFromFS();
+  _loaded = true;
+  // the load may be deferred until after WiFi has connected
+  onConfigUpdated();
 }
 
 void MqttSettingsService::loop() {
@@ -87,6 +96,7 @@ AsyncMqttClient* MqttSettingsService::getMqttClient() {
 }
 
 void MqttSettingsService::onMqttConnect(bool sessionPresent) {
+  BootProfile::mark("mqtt_connected");
   Serial.print(F("Connected to MQTT, "));
   if (sessionPresent) {
     Serial.println(F("with persistent session"));
@@ -109,28 +119,28 @@ void MqttSettingsService::onConfigUpdated() {
 
 #ifdef ESP32
 void MqttSettingsService::onStationModeGotIP(WiFiEvent_t event, WiFiEventInfo_t info) {
-  if (_state.enabled) {
+  if (_loaded && _state.enabled) {
     Serial.println(F("WiFi connection dropped, starting MQTT client."));
     onConfigUpdated();
   }
 }
 
 void MqttSettingsService::onStationModeDisconnected(WiFiEvent_t event, WiFiEventInfo_t info) {
-  if (_state.enabled) {
+  if (_loaded && _state.enabled) {
     Serial.println(F("WiFi connection dropped, stopping MQTT client."));
     onConfigUpdated();
   }
 }
 #elif defined(ESP8266)
 void MqttSettingsService::onStationModeGotIP(const WiFiEventStationModeGotIP& event) {
-  if (_state.enabled) {
+  if (_loaded && _state.enabled) {
     Serial.println(F("WiFi connection dropped, starting MQTT client."));
     onConfigUpdated();
   }
 }
 
 void MqttSettingsService::onStationModeDisconnected(const WiFiEventStationModeDisconnected& event) {
-  if (_state.enabled) {
+  if (_loaded && _state.enabled) {
     Serial.println(F("WiFi connection dropped, stopping MQTT client."));
     onConfigUpdated();
   }
@@ -5,6 +5,7 @@
 #include <HttpEndpoint.h>
 #include <FSPersistence.h>
 #include <AsyncMqttClient.h>
+#include <BootProfile.h>
 #include <ESPUtils.h>
 
 #define MQTT_RECONNECTION_DELAY 5000
@@ -131,6 +132,8 @@ class MqttSettingsService : public StatefulService<MqttSettings> {
   // variable to help manage connection
   bool _reconfigureMqtt;
   unsigned long _disconnectedAt;
+  // WiFi events seen before begin() has loaded the settings are left to the reconfigure it flags
+  bool _loaded;
 
   // connection status
   AsyncMqttClientDisconnectReason _disconnectReason;
@@ -6,19 +6,25 @@ MqttStatus::MqttStatus(AsyncWebServer* server,
     _mqttSettingsService(mqttSettingsService) {
   server->on(MQTT_STATUS_SERVICE_PATH,
              HTTP_GET,
-             securityManager->wrapRequest(std::bind(&MqttStatus::mqttStatus, this, std::placeholders::_1),
-                                          AuthenticationPredicates::IS_AUTHENTICATED));
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&MqttStatus::mqttStatus, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_AUTHENTICATED),
+                 RequestPriority::BACKGROUND,
+                 MAX_MQTT_STATUS_SIZE));
 }
 
 void MqttStatus::mqttStatus(AsyncWebServerRequest* request) {
   AsyncJsonResponse* response = new AsyncJsonResponse(false, MAX_MQTT_STATUS_SIZE);
   JsonObject root = response->getRoot();
-
-  root["enabled"] = _mqttSettingsService->isEnabled();
-  root["connected"] = _mqttSettingsService->isConnected();
-  root["client_id"] = _mqttSettingsService->getClientId();
-  root["disconnect_reason"] = (uint8_t)_mqttSettingsService->getDisconnectReason();
-
+  read(this, root);
   response->setLength();
   request->send(response);
 }
+
+void MqttStatus::read(void* context, JsonObject& root) {
+  MqttStatus* status = static_cast<MqttStatus*>(context);
+  root["enabled"] = status->_mqttSettingsService->isEnabled();
+  root["connected"] = status->_mqttSettingsService->isConnected();
+  root["client_id"] = status->_mqttSettingsService->getClientId();
+  root["disconnect_reason"] = (uint8_t)status->_mqttSettingsService->getDisconnectReason();
+}
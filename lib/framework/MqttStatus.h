@@ -10,6 +10,7 @@
 #endif
 
 #include <MqttSettingsService.h>
+#include <AdmissionControl.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
@@ -22,6 +23,9 @@ class MqttStatus {
  public:
   MqttStatus(AsyncWebServer* server, MqttSettingsService* mqttSettingsService, SecurityManager* securityManager);
 
+  // writes the status to root, also used to serve the status from the batch endpoint
+  static void read(void* context, JsonObject& root);
+
  private:
   MqttSettingsService* _mqttSettingsService;
 
@@ -1,12 +1,25 @@
 #include <NTPSettingsService.h>
 
 NTPSettingsService::NTPSettingsService(AsyncWebServer* server, FS* fs, SecurityManager* securityManager) :
-    _httpEndpoint(NTPSettings::read, NTPSettings::update, this, server, NTP_SETTINGS_SERVICE_PATH, securityManager),
-    _fsPersistence(NTPSettings::read, NTPSettings::update, this, fs, NTP_SETTINGS_FILE),
+    _httpEndpoint(NTPSettingsFields::read,
+                  NTPSettingsFields::update,
+                  this,
+                  server,
+                  NTP_SETTINGS_SERVICE_PATH,
+                  securityManager,
+                  AuthenticationPredicates::IS_ADMIN,
+                  NTPSettingsFields::capacity()),
+    _fsPersistence(NTPSettingsFields::read,
+                   NTPSettingsFields::load,
+                   this,
+                   fs,
+                   NTP_SETTINGS_FILE,
+                   NTPSettingsFields::capacity()),
     _timeHandler(TIME_PATH,
                  securityManager->wrapCallback(
                      std::bind(&NTPSettingsService::configureTime, this, std::placeholders::_1, std::placeholders::_2),
-                     AuthenticationPredicates::IS_ADMIN)) {
+                     AuthenticationPredicates::IS_ADMIN)),
+    _loaded(false) {
   _timeHandler.setMethod(HTTP_POST);
   _timeHandler.setMaxContentLength(MAX_TIME_SIZE);
   server->addHandler(&_timeHandler);
@@ -22,31 +35,49 @@ NTPSettingsService::NTPSettingsService(AsyncWebServer* server, FS* fs, SecurityM
   _onStationModeGotIPHandler =
       WiFi.onStationModeGotIP(std::bind(&NTPSettingsService::onStationModeGotIP, this, std::placeholders::_1));
 #endif
-  addUpdateHandler([&](const String& originId) { configureNTP(); }, false);
+  addUpdateHandler(
+      [](void* context, const String& originId, state_field_mask_t changedFields) {
+        static_cast<NTPSettingsService*>(context)->configureNTP();
+      },
+      this,
+      false);
 }
 
 void NTPSettingsService::begin() {
   _fsPersistence.readFromFS();
+  _loaded = true;
   configureNTP();
 }
 
 #ifdef ESP32
 void NTPSettingsService::onStationModeGotIP(WiFiEvent_t event, WiFiEventInfo_t info) {
+  if (!_loaded) {
+    return;
+  }
   Serial.println(F("Got IP address, starting NTP Synchronization"));
   configureNTP();
 }
 
 void NTPSettingsService::onStationModeDisconnected(WiFiEvent_t event, WiFiEventInfo_t info) {
+  if (!_loaded) {
+    return;
+  }
   Serial.println(F("WiFi connection dropped, stopping NTP."));
   configureNTP();
 }
 #elif defined(ESP8266)
 void NTPSettingsService::onStationModeGotIP(const WiFiEventStationModeGotIP& event) {
+  if (!_loaded) {
+    return;
+  }
   Serial.println(F("Got IP address, starting NTP Synchronization"));
   configureNTP();
 }
 
 void NTPSettingsService::onStationModeDisconnected(const WiFiEventStationModeDisconnected& event) {
+  if (!_loaded) {
+    return;
+  }
   Serial.println(F("WiFi connection dropped, stopping NTP."));
   configureNTP();
 }
@@ -3,6 +3,7 @@
 
 #include <HttpEndpoint.h>
 #include <FSPersistence.h>
+#include <JsonStateFields.h>
 
 #include <time.h>
 #ifdef ESP32
@@ -29,6 +30,8 @@
 
 #define NTP_SETTINGS_FILE "/config/ntpSettings.json"
 #define NTP_SETTINGS_SERVICE_PATH "/rest/ntpSettings"
+#define NTP_SERVER_MAX_LENGTH 64
+#define NTP_TIME_ZONE_MAX_LENGTH 64
 
 #define MAX_TIME_SIZE 256
 #define TIME_PATH "/rest/time"
@@ -39,23 +42,25 @@ class NTPSettings {
   String tzLabel;
   String tzFormat;
   String server;
-
-  static void read(NTPSettings& settings, JsonObject& root) {
-    root["enabled"] = settings.enabled;
-    root["server"] = settings.server;
-    root["tz_label"] = settings.tzLabel;
-    root["tz_format"] = settings.tzFormat;
-  }
-
-  static StateUpdateResult update(JsonObject& root, NTPSettings& settings) {
-    settings.enabled = root["enabled"] | FACTORY_NTP_ENABLED;
-    settings.server = root["server"] | FACTORY_NTP_SERVER;
-    settings.tzLabel = root["tz_label"] | FACTORY_NTP_TIME_ZONE_LABEL;
-    settings.tzFormat = root["tz_format"] | FACTORY_NTP_TIME_ZONE_FORMAT;
-    return StateUpdateResult::CHANGED;
-  }
 };
 
+JSON_STATE_FIELD(NTPEnabledField, NTPSettings, enabled, "enabled", FACTORY_NTP_ENABLED);
+JSON_STATE_STRING_FIELD(NTPServerField, NTPSettings, server, "server", FACTORY_NTP_SERVER, NTP_SERVER_MAX_LENGTH);
+JSON_STATE_STRING_FIELD(NTPTimeZoneLabelField,
+                        NTPSettings,
+                        tzLabel,
+                        "tz_label",
+                        FACTORY_NTP_TIME_ZONE_LABEL,
+                        NTP_TIME_ZONE_MAX_LENGTH);
+JSON_STATE_STRING_FIELD(NTPTimeZoneFormatField,
+                        NTPSettings,
+                        tzFormat,
+                        "tz_format",
+                        FACTORY_NTP_TIME_ZONE_FORMAT,
+                        NTP_TIME_ZONE_MAX_LENGTH);
+typedef JsonStateFields<NTPSettings, NTPEnabledField, NTPServerField, NTPTimeZoneLabelField, NTPTimeZoneFormatField>
+    NTPSettingsFields;
+
 class NTPSettingsService : public StatefulService<NTPSettings> {
  public:
   NTPSettingsService(AsyncWebServer* server, FS* fs, SecurityManager* securityManager);
@@ -67,6 +72,9 @@ class NTPSettingsService : public StatefulService<NTPSettings> {
   FSPersistence<NTPSettings> _fsPersistence;
   AsyncCallbackJsonWebHandler _timeHandler;
 
+  // WiFi events are ignored until begin() has loaded the settings, which configures NTP for the connection state then
+  bool _loaded;
+
 #ifdef ESP32
   void onStationModeGotIP(WiFiEvent_t event, WiFiEventInfo_t info);
   void onStationModeDisconnected(WiFiEvent_t event, WiFiEventInfo_t info);
@@ -3,8 +3,11 @@
 NTPStatus::NTPStatus(AsyncWebServer* server, SecurityManager* securityManager) {
   server->on(NTP_STATUS_SERVICE_PATH,
              HTTP_GET,
-             securityManager->wrapRequest(std::bind(&NTPStatus::ntpStatus, this, std::placeholders::_1),
-                                          AuthenticationPredicates::IS_AUTHENTICATED));
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&NTPStatus::ntpStatus, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_AUTHENTICATED),
+                 RequestPriority::BACKGROUND,
+                 MAX_NTP_STATUS_SIZE));
 }
 
 String toISOString(tm* time, bool incOffset) {
@@ -16,7 +19,12 @@ String toISOString(tm* time, bool incOffset) {
 void NTPStatus::ntpStatus(AsyncWebServerRequest* request) {
   AsyncJsonResponse* response = new AsyncJsonResponse(false, MAX_NTP_STATUS_SIZE);
   JsonObject root = response->getRoot();
+  read(this, root);
+  response->setLength();
+  request->send(response);
+}
 
+void NTPStatus::read(void* context, JsonObject& root) {
   // grab the current instant in unix seconds
   time_t now = time(nullptr);
 
@@ -34,7 +42,4 @@ void NTPStatus::ntpStatus(AsyncWebServerRequest* request) {
 
   // device uptime in seconds
   root["uptime"] = millis() / 1000;
-
-  response->setLength();
-  request->send(response);
 }
@@ -12,6 +12,7 @@
 #include <sntp.h>
 #endif
 
+#include <AdmissionControl.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
@@ -24,6 +25,9 @@ class NTPStatus {
  public:
   NTPStatus(AsyncWebServer* server, SecurityManager* securityManager);
 
+  // writes the status to root, also used to serve the status from the batch endpoint
+  static void read(void* context, JsonObject& root);
+
  private:
   void ntpStatus(AsyncWebServerRequest* request);
 };
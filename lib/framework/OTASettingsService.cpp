@@ -1,9 +1,22 @@
 #include <OTASettingsService.h>
 
 OTASettingsService::OTASettingsService(AsyncWebServer* server, FS* fs, SecurityManager* securityManager) :
-    _httpEndpoint(OTASettings::read, OTASettings::update, this, server, OTA_SETTINGS_SERVICE_PATH, securityManager),
-    _fsPersistence(OTASettings::read, OTASettings::update, this, fs, OTA_SETTINGS_FILE),
-    _arduinoOTA(nullptr) {
+    _httpEndpoint(OTASettingsFields::read,
+                  OTASettingsFields::update,
+                  this,
+                  server,
+                  OTA_SETTINGS_SERVICE_PATH,
+                  securityManager,
+                  AuthenticationPredicates::IS_ADMIN,
+                  OTASettingsFields::capacity()),
+    _fsPersistence(OTASettingsFields::read,
+                   OTASettingsFields::load,
+                   this,
+                   fs,
+                   OTA_SETTINGS_FILE,
+                   OTASettingsFields::capacity()),
+    _arduinoOTA(nullptr),
+    _loaded(false) {
 #ifdef ESP32
   WiFi.onEvent(std::bind(&OTASettingsService::onStationModeGotIP, this, std::placeholders::_1, std::placeholders::_2),
                WiFiEvent_t::SYSTEM_EVENT_STA_GOT_IP);
@@ -11,11 +24,17 @@ OTASettingsService::OTASettingsService(AsyncWebServer* server, FS* fs, SecurityM
   _onStationModeGotIPHandler =
       WiFi.onStationModeGotIP(std::bind(&OTASettingsService::onStationModeGotIP, this, std::placeholders::_1));
 #endif
-  addUpdateHandler([&](const String& originId) { configureArduinoOTA(); }, false);
+  addUpdateHandler(
+      [](void* context, const String& originId, state_field_mask_t changedFields) {
+        static_cast<OTASettingsService*>(context)->configureArduinoOTA();
+      },
+      this,
+      false);
 }
 
 void OTASettingsService::begin() {
   _fsPersistence.readFromFS();
+  _loaded = true;
   configureArduinoOTA();
 }
 
@@ -38,7 +57,10 @@ void OTASettingsService::configureArduinoOTA() {
     _arduinoOTA = new ArduinoOTAClass;
     _arduinoOTA->setPort(_state.port);
     _arduinoOTA->setPassword(_state.password.c_str());
-    _arduinoOTA->onStart([]() { Serial.println(F("Starting")); });
+    _arduinoOTA->onStart([]() {
+      Serial.println(F("Starting"));
+      WriteBehind::flushAll();
+    });
     _arduinoOTA->onEnd([]() { Serial.println(F("\r\nEnd")); });
     _arduinoOTA->onProgress([](unsigned int progress, unsigned int total) {
       Serial.printf_P(PSTR("Progress: %u%%\r\n"), (progress / (total / 100)));
@@ -62,10 +84,14 @@ void OTASettingsService::configureArduinoOTA() {
 
 #ifdef ESP32
 void OTASettingsService::onStationModeGotIP(WiFiEvent_t event, WiFiEventInfo_t info) {
-  configureArduinoOTA();
+  if (_loaded) {
+    configureArduinoOTA();
+  }
 }
 #elif defined(ESP8266)
 void OTASettingsService::onStationModeGotIP(const WiFiEventStationModeGotIP& event) {
-  configureArduinoOTA();
+  if (_loaded) {
+    configureArduinoOTA();
+  }
 }
 #endif
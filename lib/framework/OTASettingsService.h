@@ -3,6 +3,7 @@
 
 #include <HttpEndpoint.h>
 #include <FSPersistence.h>
+#include <JsonStateFields.h>
 
 #ifdef ESP32
 #include <ESPmDNS.h>
@@ -27,27 +28,25 @@
 
 #define OTA_SETTINGS_FILE "/config/otaSettings.json"
 #define OTA_SETTINGS_SERVICE_PATH "/rest/otaSettings"
+#define OTA_PASSWORD_MAX_LENGTH 64
 
 class OTASettings {
  public:
   bool enabled;
   int port;
   String password;
-
-  static void read(OTASettings& settings, JsonObject& root) {
-    root["enabled"] = settings.enabled;
-    root["port"] = settings.port;
-    root["password"] = settings.password;
-  }
-
-  static StateUpdateResult update(JsonObject& root, OTASettings& settings) {
-    settings.enabled = root["enabled"] | FACTORY_OTA_ENABLED;
-    settings.port = root["port"] | FACTORY_OTA_PORT;
-    settings.password = root["password"] | FACTORY_OTA_PASSWORD;
-    return StateUpdateResult::CHANGED;
-  }
 };
 
+JSON_STATE_FIELD(OTAEnabledField, OTASettings, enabled, "enabled", FACTORY_OTA_ENABLED);
+JSON_STATE_FIELD(OTAPortField, OTASettings, port, "port", FACTORY_OTA_PORT);
+JSON_STATE_STRING_FIELD(OTAPasswordField,
+                        OTASettings,
+                        password,
+                        "password",
+                        FACTORY_OTA_PASSWORD,
+                        OTA_PASSWORD_MAX_LENGTH);
+typedef JsonStateFields<OTASettings, OTAEnabledField, OTAPortField, OTAPasswordField> OTASettingsFields;
+
 class OTASettingsService : public StatefulService<OTASettings> {
  public:
   OTASettingsService(AsyncWebServer* server, FS* fs, SecurityManager* securityManager);
@@ -59,6 +58,8 @@ class OTASettingsService : public StatefulService<OTASettings> {
   HttpEndpoint<OTASettings> _httpEndpoint;
   FSPersistence<OTASettings> _fsPersistence;
   ArduinoOTAClass* _arduinoOTA;
+  // set once begin() has loaded the settings, OTA is not started on a WiFi connection before then
+  bool _loaded;
 
   void configureArduinoOTA();
 #ifdef ESP32
@@ -0,0 +1,71 @@
+#ifndef PayloadCache_h
+#define PayloadCache_h
+
+#include <Arduino.h>
+
+/**
+ * Holds the payloads most recently serialized from a service's state, each keyed by the reader which produced it and
+ * the revision of the state it was produced from. An entry is only returned while its revision is current, so updates
+ * invalidate the cache without having to visit it. Entries are replaced in the order they were added once all slots
+ * are in use.
+ *
+ * Access must be serialized by the service's access mutex.
+ */
+template <class Key, uint8_t Capacity>
+class PayloadCache {
+ public:
+  PayloadCache() : _next(0) {
+    for (uint8_t i = 0; i < Capacity; i++) {
+      _entries[i].key = nullptr;
+    }
+  }
+
+  bool load(Key key, uint32_t revision, String& payload) const {
+    for (uint8_t i = 0; i < Capacity; i++) {
+      if (_entries[i].key == key && _entries[i].revision == revision) {
+        payload = _entries[i].payload;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void store(Key key, uint32_t revision, const String& payload) {
+    Entry* entry = nullptr;
+    for (uint8_t i = 0; i < Capacity && !entry; i++) {
+      if (_entries[i].key == key) {
+        entry = &_entries[i];
+      }
+    }
+    if (!entry) {
+      entry = &_entries[_next];
+      _next = (_next + 1) % Capacity;
+    }
+    entry->key = key;
+    entry->revision = revision;
+    entry->payload = payload;
+  }
+
+ private:
+  struct Entry {
+    Key key;
+    uint32_t revision;
+    String payload;
+  };
+
+  Entry _entries[Capacity];
+  uint8_t _next;
+};
+
+template <class Key>
+class PayloadCache<Key, 0> {
+ public:
+  bool load(Key key, uint32_t revision, String& payload) const {
+    return false;
+  }
+
+  void store(Key key, uint32_t revision, const String& payload) {
+  }
+};
+
+#endif  // end PayloadCache_h
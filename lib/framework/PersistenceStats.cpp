@@ -0,0 +1,66 @@
+#include <PersistenceStats.h>
+#include <JsonDocumentPool.h>
+
+PersistenceCounters* PersistenceCounters::_first = nullptr;
+
+PersistenceCounters::PersistenceCounters(const char* filePath) :
+    _filePath(filePath), _next(_first), _writes(0), _skipped(0), _crc(0), _persisted(false) {
+  _first = this;
+}
+
+PersistenceCounters::~PersistenceCounters() {
+  for (PersistenceCounters** counters = &_first; *counters; counters = &(*counters)->_next) {
+    if (*counters == this) {
+      *counters = _next;
+      break;
+    }
+  }
+}
+
+void PersistenceCounters::read(JsonObject& root) const {
+  root["path"] = _filePath;
+  root["writes"] = _writes;
+  root["skipped"] = _skipped;
+  if (_persisted) {
+    char crc[9];
+    snprintf(crc, sizeof(crc), "%08lx", (unsigned long)_crc);
+    root["crc"] = crc;
+  }
+}
+
+size_t PersistenceCounters::count() {
+  size_t count = 0;
+  for (PersistenceCounters* counters = _first; counters; counters = counters->_next) {
+    count++;
+  }
+  return count;
+}
+
+void PersistenceCounters::readAll(JsonArray& files) {
+  for (PersistenceCounters* counters = _first; counters; counters = counters->_next) {
+    JsonObject file = files.createNestedObject();
+    counters->read(file);
+  }
+}
+
+PersistenceStats::PersistenceStats(AsyncWebServer* server, SecurityManager* securityManager) {
+  server->on(PERSISTENCE_STATS_SERVICE_PATH,
+             HTTP_GET,
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(
+                     std::bind(&PersistenceStats::persistenceStats, this, std::placeholders::_1),
+                     AuthenticationPredicates::IS_AUTHENTICATED),
+                 RequestPriority::BACKGROUND,
+                 MAX_PERSISTENCE_STATS_SIZE));
+}
+
+void PersistenceStats::persistenceStats(AsyncWebServerRequest* request) {
+  // file paths are not copied, checksums are
+  size_t count = PersistenceCounters::count();
+  PooledJsonDocument jsonDocument(JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(count) + count * (JSON_OBJECT_SIZE(4) + 9));
+  JsonArray files = jsonDocument.createNestedArray("files");
+  PersistenceCounters::readAll(files);
+  String payload;
+  serializeJson(jsonDocument, payload);
+  request->send(200, JSON_MIMETYPE, payload);
+}
@@ -0,0 +1,78 @@
+#ifndef PersistenceStats_h
+#define PersistenceStats_h
+
+#ifdef ESP32
+#include <WiFi.h>
+#include <AsyncTCP.h>
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#include <ESPAsyncTCP.h>
+#endif
+
+#include <AdmissionControl.h>
+#include <ArduinoJson.h>
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+#include <SecurityManager.h>
+
+#define PERSISTENCE_STATS_SERVICE_PATH "/rest/persistenceStats"
+
+// reserved when admitting a request, the response itself grows with the number of files
+#define MAX_PERSISTENCE_STATS_SIZE 1024
+
+/**
+ * Write counters for a single FSPersistence instance, along with the checksum of the state it last persisted which is
+ * used to skip writes that would not change what is on flash.
+ *
+ * Every instance is kept in a list so PersistenceStats can report on them all.
+ */
+class PersistenceCounters {
+ public:
+  PersistenceCounters(const char* filePath);
+  ~PersistenceCounters();
+
+  bool matches(uint32_t crc) const {
+    return _persisted && _crc == crc;
+  }
+
+  void persisted(uint32_t crc) {
+    _crc = crc;
+    _persisted = true;
+  }
+
+  void written() {
+    _writes++;
+  }
+
+  void skipped() {
+    _skipped++;
+  }
+
+  void read(JsonObject& root) const;
+
+  static size_t count();
+  static void readAll(JsonArray& files);
+
+ private:
+  static PersistenceCounters* _first;
+
+  const char* _filePath;
+  PersistenceCounters* _next;
+  uint32_t _writes;
+  uint32_t _skipped;
+  uint32_t _crc;
+  bool _persisted;
+};
+
+/**
+ * Reports the writes issued and skipped by each FSPersistence instance.
+ */
+class PersistenceStats {
+ public:
+  PersistenceStats(AsyncWebServer* server, SecurityManager* securityManager);
+
+ private:
+  void persistenceStats(AsyncWebServerRequest* request);
+};
+
+#endif  // end PersistenceStats_h
@@ -0,0 +1,93 @@
+#include <PropagationQueue.h>
+#include <LoopHook.h>
+
+#ifdef ESP32
+static portMUX_TYPE queueMux = portMUX_INITIALIZER_UNLOCKED;
+#define QUEUE_LOCK() portENTER_CRITICAL(&queueMux)
+#define QUEUE_UNLOCK() portEXIT_CRITICAL(&queueMux)
+#else
+#define QUEUE_LOCK()
+#define QUEUE_UNLOCK()
+#endif
+
+PropagationQueue::Entry PropagationQueue::_entries[PROPAGATION_QUEUE_CAPACITY];
+uint8_t PropagationQueue::_count = 0;
+uint32_t PropagationQueue::_propagated = 0;
+uint32_t PropagationQueue::_overflows = 0;
+uint32_t PropagationQueue::_totalLatency = 0;
+uint32_t PropagationQueue::_maxLatency = 0;
+
+static void drainQueue(void* context) {
+  PropagationQueue::drain();
+}
+
+// attached as the services are constructed, before the loop runs
+static struct DrainHook : LoopHook {
+  DrainHook() : LoopHook(drainQueue, nullptr) {
+    attach();
+  }
+} drainHook;
+
+bool PropagationQueue::queue(PropagationFunction function, void* context, const char* originId, const void* heldBy) {
+  bool queued = true;
+  QUEUE_LOCK();
+  uint8_t i = 0;
+  while (i < _count && (_entries[i].function != function || _entries[i].context != context)) {
+    i++;
+  }
+  if (i < _count) {
+    // the queued propagation reports the fields changed by both, and waits for the later request within its deadline
+    if (strcmp(_entries[i].originId, originId)) {
+      _entries[i].originId = COALESCED_ORIGIN_ID;
+    }
+    _entries[i].heldBy = heldBy;
+  } else if (_count < PROPAGATION_QUEUE_CAPACITY) {
+    _entries[_count++] = {function, context, originId, heldBy, (uint32_t)millis()};
+  } else {
+    _overflows++;
+    queued = false;
+  }
+  QUEUE_UNLOCK();
+  return queued;
+}
+
+void PropagationQueue::release(const void* heldBy) {
+  QUEUE_LOCK();
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_entries[i].heldBy == heldBy) {
+      _entries[i].heldBy = nullptr;
+    }
+  }
+  QUEUE_UNLOCK();
+}
+
+void PropagationQueue::drain() {
+  // only the loop removes entries, so the count may be checked before taking the lock
+  if (!_count) {
+    return;
+  }
+  uint32_t now = millis();
+  QUEUE_LOCK();
+  for (uint8_t i = 0; i < _count;) {
+    Entry entry = _entries[i];
+    if (entry.heldBy && now - entry.queuedAt < PROPAGATION_QUEUE_DEADLINE) {
+      i++;
+      continue;
+    }
+    // kept in order, so services propagate in the order they were changed
+    for (uint8_t j = i + 1; j < _count; j++) {
+      _entries[j - 1] = _entries[j];
+    }
+    _count--;
+    QUEUE_UNLOCK();
+    entry.function(entry.context, entry.originId);
+    uint32_t latency = millis() - entry.queuedAt;
+    QUEUE_LOCK();
+    _propagated++;
+    _totalLatency += latency;
+    if (latency > _maxLatency) {
+      _maxLatency = latency;
+    }
+  }
+  QUEUE_UNLOCK();
+}
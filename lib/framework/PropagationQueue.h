@@ -0,0 +1,78 @@
+#ifndef PropagationQueue_h
+#define PropagationQueue_h
+
+#include <Arduino.h>
+
+// propagations queued at once, further changes propagate when their request disconnects
+#ifndef PROPAGATION_QUEUE_CAPACITY
+#define PROPAGATION_QUEUE_CAPACITY 8
+#endif
+
+// milliseconds a propagation waits for the request which queued it to disconnect
+#ifndef PROPAGATION_QUEUE_DEADLINE
+#define PROPAGATION_QUEUE_DEADLINE 100
+#endif
+
+// Origin reported when a deferred propagation covers updates from more than one origin
+#define COALESCED_ORIGIN_ID "coalesced"
+
+typedef void (*PropagationFunction)(void* context, const char* originId);
+
+/**
+ * Carries changes made by REST requests to the update handlers from ESP8266React::loop(), rather than from the
+ * request's disconnect handler, so they reach MQTT and WebSocket clients however long the client keeps the connection
+ * alive and even if it is aborted.
+ *
+ * A propagation is held until the request which queued it has disconnected, so handlers which reconfigure the network
+ * do not cut the response short, but for no longer than PROPAGATION_QUEUE_DEADLINE milliseconds. A change to a service
+ * which is already queued joins the queued propagation. The time from queueing to propagation is recorded.
+ */
+class PropagationQueue {
+ public:
+  /**
+   * Queues a call of function with context and originId, held until release() is called with heldBy. Returns false if
+   * the queue is full.
+   */
+  static bool queue(PropagationFunction function, void* context, const char* originId, const void* heldBy);
+
+  // lets the propagations held by heldBy run on the next pass of the loop
+  static void release(const void* heldBy);
+
+  // runs the propagations which are due, called from the loop
+  static void drain();
+
+  static uint32_t getPropagated() {
+    return _propagated;
+  }
+
+  static uint32_t getOverflows() {
+    return _overflows;
+  }
+
+  // mean and longest time from queueing to propagation in milliseconds
+  static uint32_t getMeanLatency() {
+    return _propagated ? _totalLatency / _propagated : 0;
+  }
+
+  static uint32_t getMaxLatency() {
+    return _maxLatency;
+  }
+
+ private:
+  struct Entry {
+    PropagationFunction function;
+    void* context;
+    const char* originId;
+    const void* heldBy;
+    uint32_t queuedAt;
+  };
+
+  static Entry _entries[PROPAGATION_QUEUE_CAPACITY];
+  static uint8_t _count;
+  static uint32_t _propagated;
+  static uint32_t _overflows;
+  static uint32_t _totalLatency;
+  static uint32_t _maxLatency;
+};
+
+#endif  // end PropagationQueue_h
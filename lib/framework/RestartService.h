@@ -10,7 +10,9 @@
 #endif
 
 #include <ESPAsyncWebServer.h>
+#include <AdmissionControl.h>
 #include <SecurityManager.h>
+#include <WriteBehind.h>
 
 #define RESTART_SERVICE_PATH "/rest/restart"
 
@@ -19,6 +21,7 @@ class RestartService {
   RestartService(AsyncWebServer* server, SecurityManager* securityManager);
 
   static void restartNow() {
+    WriteBehind::flushAll();
     WiFi.disconnect(true);
     delay(500);
     ESP.restart();
@@ -88,12 +88,17 @@ class SecurityManager {
 
   /**
    * Wrap the provided request to provide validation against an AuthenticationPredicate.
+   *
+   * The result is often wrapped again by AdmissionControl, which holds the request's disconnect handler until the
+   * request disconnects. Wrapped handlers register their disconnect callbacks through AdmissionControl::onDisconnect()
+   * rather than request->onDisconnect(), which would replace the hold's.
    */
   virtual ArRequestHandlerFunction wrapRequest(ArRequestHandlerFunction onRequest,
                                                AuthenticationPredicate predicate) = 0;
 
   /**
-   * Wrap the provided json request callback to provide validation against an AuthenticationPredicate.
+   * Wrap the provided json request callback to provide validation against an AuthenticationPredicate. Disconnect
+   * callbacks are registered as for wrapRequest().
    */
   virtual ArJsonRequestHandlerFunction wrapCallback(ArJsonRequestHandlerFunction onRequest,
                                                     AuthenticationPredicate predicate) = 0;
@@ -6,7 +6,12 @@ SecuritySettingsService::SecuritySettingsService(AsyncWebServer* server, FS* fs)
     _httpEndpoint(SecuritySettings::read, SecuritySettings::update, this, server, SECURITY_SETTINGS_PATH, this),
     _fsPersistence(SecuritySettings::read, SecuritySettings::update, this, fs, SECURITY_SETTINGS_FILE),
     _jwtHandler(FACTORY_JWT_SECRET) {
-  addUpdateHandler([&](const String& originId) { configureJWTHandler(); }, false);
+  addUpdateHandler(
+      [](void* context, const String& originId, state_field_mask_t changedFields) {
+        static_cast<SecuritySettingsService*>(context)->configureJWTHandler();
+      },
+      this,
+      false);
 }
 
 void SecuritySettingsService::begin() {
@@ -35,7 +40,7 @@ void SecuritySettingsService::configureJWTHandler() {
 }
 
 Authentication SecuritySettingsService::authenticateJWT(String& jwt) {
-  DynamicJsonDocument payloadDocument(MAX_JWT_SIZE);
+  PooledJsonDocument payloadDocument(MAX_JWT_SIZE);
   _jwtHandler.parseJWT(jwt, payloadDocument);
   if (payloadDocument.is<JsonObject>()) {
     JsonObject parsedPayload = payloadDocument.as<JsonObject>();
@@ -64,14 +69,14 @@ inline void populateJWTPayload(JsonObject& payload, User* user) {
 }
 
 boolean SecuritySettingsService::validatePayload(JsonObject& parsedPayload, User* user) {
-  DynamicJsonDocument jsonDocument(MAX_JWT_SIZE);
+  PooledJsonDocument jsonDocument(MAX_JWT_SIZE);
   JsonObject payload = jsonDocument.to<JsonObject>();
   populateJWTPayload(payload, user);
   return payload == parsedPayload;
 }
 
 String SecuritySettingsService::generateJWT(User* user) {
-  DynamicJsonDocument jsonDocument(MAX_JWT_SIZE);
+  PooledJsonDocument jsonDocument(MAX_JWT_SIZE);
   JsonObject payload = jsonDocument.to<JsonObject>();
   populateJWTPayload(payload, user);
   return _jwtHandler.buildJWT(payload);
@@ -0,0 +1,74 @@
+#ifndef StateSnapshot_h
+#define StateSnapshot_h
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <string.h>
+
+#ifndef STATE_SNAPSHOT_READ_ATTEMPTS
+#define STATE_SNAPSHOT_READ_ATTEMPTS 8
+#endif
+
+/**
+ * A copy of a service's state guarded by a sequence lock.
+ *
+ * The writer, which must already be serialized by the service's access mutex, makes the sequence number odd, copies
+ * the state in and makes it even again. Readers copy the state out and retry if the sequence number was odd or changed
+ * while they were copying, so they never block the writer and the writer never waits on them.
+ *
+ * Only the load and store of the sequence number are atomic, read-modify-write operations are not required.
+ */
+template <class T, bool Enabled>
+class StateSnapshot {
+ public:
+  void store(const T& state) {
+  }
+
+  bool load(T& state) const {
+    return false;
+  }
+};
+
+template <class T>
+class StateSnapshot<T, true> {
+  static_assert(__has_trivial_copy(T) && __has_trivial_destructor(T),
+                "Snapshot reads require trivially copyable state");
+
+ public:
+  StateSnapshot() : _sequence(0) {
+  }
+
+  void store(const T& state) {
+    uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&_state, &state, sizeof(T));
+    _sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * Copies the latest state, returning false if a consistent copy could not be made within
+   * STATE_SNAPSHOT_READ_ATTEMPTS. This happens when the writer is preempted mid-store by the reader's task.
+   */
+  bool load(T& state) const {
+    for (uint8_t attempt = 0; attempt < STATE_SNAPSHOT_READ_ATTEMPTS; attempt++) {
+      uint32_t sequence = _sequence.load(std::memory_order_acquire);
+      if (sequence & 1) {
+        continue;
+      }
+      memcpy(&state, &_state, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_sequence.load(std::memory_order_relaxed) == sequence) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  std::atomic<uint32_t> _sequence;
+  T _state;
+};
+
+#endif  // end StateSnapshot_h
@@ -1,3 +1,4 @@
 #include <StatefulService.h>
 
 update_handler_id_t StateUpdateHandlerInfo::currentUpdatedHandlerId = 0;
+uint16_t StateUpdateHandlerInfo::refusedCount = 0;
@@ -3,9 +3,14 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <JsonDocumentPool.h>
+#include <LoopHook.h>
+#include <PayloadCache.h>
+#include <PropagationQueue.h>
+#include <StateSnapshot.h>
 
-#include <list>
 #include <functional>
+#include <type_traits>
 #ifdef ESP32
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
@@ -15,6 +20,10 @@
 #define DEFAULT_BUFFER_SIZE 1024
 #endif
 
+#ifndef DEFAULT_UPDATE_HANDLER_CAPACITY
+#define DEFAULT_UPDATE_HANDLER_CAPACITY 4
+#endif
+
 enum class StateUpdateResult {
   CHANGED = 0,  // The update changed the state and propagation should take place if required
   UNCHANGED,    // The state was unchanged, propagation should not take place
@@ -24,49 +33,188 @@ enum class StateUpdateResult {
 template <typename T>
 using JsonStateUpdater = std::function<StateUpdateResult(JsonObject& root, T& settings)>;
 
+/**
+ * A std::function which remembers the plain function it was constructed from, if any. The function identifies the
+ * payloads the reader produces so they can be shared through the service's payload cache.
+ */
+template <typename T>
+class JsonStateReader : public std::function<void(T& settings, JsonObject& root)> {
+ public:
+  typedef void (*Function)(T& settings, JsonObject& root);
+
+  JsonStateReader() : _function(nullptr) {
+  }
+
+  JsonStateReader(Function function) : std::function<void(T&, JsonObject&)>(function), _function(function) {
+  }
+
+  template <typename F,
+            typename D = typename std::decay<F>::type,
+            typename = typename std::enable_if<!std::is_same<D, Function>::value &&
+                                               !std::is_same<D, JsonStateReader>::value>::type>
+  JsonStateReader(F function) : std::function<void(T&, JsonObject&)>(function), _function(nullptr) {
+  }
+
+  Function function() const {
+    return _function;
+  }
+
+ private:
+  Function _function;
+};
+
+// keeps a parameter out of template argument deduction, so the service alone determines the state type
+template <class T>
+struct NonDeduced {
+  typedef T type;
+};
+
+typedef uint32_t state_field_mask_t;
+
+#define ALL_STATE_FIELDS ((state_field_mask_t)0xFFFFFFFF)
+
 template <typename T>
-using JsonStateReader = std::function<void(T& settings, JsonObject& root)>;
+using JsonStateFieldReader = std::function<void(T& settings, JsonObject& root, state_field_mask_t fields)>;
+
+/**
+ * Base class for state types which track the fields changed by their updaters. Each field is assigned a bit in a
+ * state_field_mask_t and updaters mark the fields they change, so the changed fields can be passed on to the update
+ * handlers. An update which returns CHANGED without marking any fields is assumed to have changed all of them.
+ */
+class TrackedState {
+ public:
+  TrackedState() : _changedFields(0) {
+  }
+
+  void markChanged(state_field_mask_t fields) {
+    _changedFields |= fields;
+  }
+
+  state_field_mask_t takeChangedFields() {
+    state_field_mask_t changedFields = _changedFields;
+    _changedFields = 0;
+    return changedFields;
+  }
+
+ private:
+  state_field_mask_t _changedFields;
+};
 
 typedef size_t update_handler_id_t;
+typedef void (*StateUpdateFunction)(void* context, const String& originId, state_field_mask_t changedFields);
 typedef std::function<void(const String& originId)> StateUpdateCallback;
 
 typedef struct StateUpdateHandlerInfo {
   static update_handler_id_t currentUpdatedHandlerId;
+  // handlers refused by a full table, across every service
+  static uint16_t refusedCount;
   update_handler_id_t _id;
-  StateUpdateCallback _cb;
+  StateUpdateFunction _function;
+  void* _context;
+  StateUpdateCallback* _callback;  // owned by the service, only set for handlers registered as a std::function
   bool _allowRemove;
-  StateUpdateHandlerInfo(StateUpdateCallback cb, bool allowRemove) :
-      _id(++currentUpdatedHandlerId), _cb(cb), _allowRemove(allowRemove){};
 } StateUpdateHandlerInfo_t;
 
+/**
+ * Per state type options for StatefulService. Specialize StateTraits for a state type, deriving from
+ * DefaultStateTraits, to override them:
+ *
+ * template <>
+ * struct StateTraits<LightState> : DefaultStateTraits {
+ *   static const bool snapshotReads = true;
+ * };
+ */
+struct DefaultStateTraits {
+  // Serve reads from a seqlock guarded copy of the state instead of under the access mutex, see StateSnapshot. Readers
+  // work on a copy, so the state must be trivially copyable and may only be modified through update().
+  static const bool snapshotReads = false;
+
+  // The number of update handlers the service can hold, addUpdateHandler() fails once they are all in use.
+  static const uint8_t updateHandlerCapacity = DEFAULT_UPDATE_HANDLER_CAPACITY;
+
+  // The number of serialized payloads kept for reuse by the endpoints until the state changes, one for each distinct
+  // reader. Payloads are only cached for readers which are plain functions, see readPayload().
+  static const uint8_t payloadCacheCapacity = 0;
+};
+
+template <class T>
+struct StateTraits : DefaultStateTraits {};
+
 template <class T>
 class StatefulService {
  public:
   template <typename... Args>
 #ifdef ESP32
   StatefulService(Args&&... args) :
-      _state(std::forward<Args>(args)...), _accessMutex(xSemaphoreCreateRecursiveMutex()) {
+      _state(std::forward<Args>(args)...),
+      _accessMutex(xSemaphoreCreateRecursiveMutex()),
+      _updateHandlerCount(0),
+      _changedFields(0),
+      _revision(initialRevision()),
+      _propagationHook(propagatePending, this),
+      _propagationInterval(0),
+      _propagatedAt(0),
+      _propagationPending(false) {
+    _snapshot.store(_state);
   }
 #else
-  StatefulService(Args&&... args) : _state(std::forward<Args>(args)...) {
+  StatefulService(Args&&... args) :
+      _state(std::forward<Args>(args)...),
+      _updateHandlerCount(0),
+      _changedFields(0),
+      _revision(initialRevision()),
+      _propagationHook(propagatePending, this),
+      _propagationInterval(0),
+      _propagatedAt(0),
+      _propagationPending(false) {
+    _snapshot.store(_state);
   }
 #endif
 
+  ~StatefulService() {
+    for (uint8_t i = 0; i < _updateHandlerCount; i++) {
+      delete _updateHandlers[i]._callback;
+    }
+  }
+
+  // the service owns the callbacks in its handler table, a copy would delete them twice
+  StatefulService(const StatefulService&) = delete;
+  StatefulService& operator=(const StatefulService&) = delete;
+
+  /**
+   * Registers a function to be called with the given context when the state changes. Registration does not allocate,
+   * returns 0 if the function is null or the service already holds updateHandlerCapacity handlers. Handlers refused by
+   * a full table are counted in StateUpdateHandlerInfo::refusedCount, which the system status reports.
+   */
+  update_handler_id_t addUpdateHandler(StateUpdateFunction function, void* context, bool allowRemove = true) {
+    return registerUpdateHandler(function, context, nullptr, allowRemove);
+  }
+
+  /**
+   * Registers a callback to be called when the state changes. The callback is copied to the heap, prefer registering a
+   * function and context where the handler is registered at boot.
+   */
   update_handler_id_t addUpdateHandler(StateUpdateCallback cb, bool allowRemove = true) {
     if (!cb) {
       return 0;
     }
-    StateUpdateHandlerInfo_t updateHandler(cb, allowRemove);
-    _updateHandlers.push_back(updateHandler);
-    return updateHandler._id;
+    StateUpdateCallback* callback = new StateUpdateCallback(cb);
+    update_handler_id_t id = registerUpdateHandler(callCallback, callback, callback, allowRemove);
+    if (!id) {
+      delete callback;
+    }
+    return id;
   }
 
   void removeUpdateHandler(update_handler_id_t id) {
-    for (auto i = _updateHandlers.begin(); i != _updateHandlers.end();) {
-      if ((*i)._allowRemove && (*i)._id == id) {
-        i = _updateHandlers.erase(i);
-      } else {
-        ++i;
+    for (uint8_t i = 0; i < _updateHandlerCount; i++) {
+      if (_updateHandlers[i]._allowRemove && _updateHandlers[i]._id == id) {
+        delete _updateHandlers[i]._callback;
+        for (uint8_t j = i + 1; j < _updateHandlerCount; j++) {
+          _updateHandlers[j - 1] = _updateHandlers[j];
+        }
+        _updateHandlerCount--;
+        return;
       }
     }
   }
@@ -74,9 +222,10 @@ class StatefulService {
   StateUpdateResult update(std::function<StateUpdateResult(T&)> stateUpdater, const String& originId) {
     beginTransaction();
     StateUpdateResult result = stateUpdater(_state);
+    commitUpdate(result);
     endTransaction();
     if (result == StateUpdateResult::CHANGED) {
-      callUpdateHandlers(originId);
+      propagate(originId);
     }
     return result;
   }
@@ -84,6 +233,7 @@ class StatefulService {
   StateUpdateResult updateWithoutPropagation(std::function<StateUpdateResult(T&)> stateUpdater) {
     beginTransaction();
     StateUpdateResult result = stateUpdater(_state);
+    commitUpdate(result);
     endTransaction();
     return result;
   }
@@ -91,9 +241,10 @@ class StatefulService {
   StateUpdateResult update(JsonObject& jsonObject, JsonStateUpdater<T> stateUpdater, const String& originId) {
     beginTransaction();
     StateUpdateResult result = stateUpdater(jsonObject, _state);
+    commitUpdate(result);
     endTransaction();
     if (result == StateUpdateResult::CHANGED) {
-      callUpdateHandlers(originId);
+      propagate(originId);
     }
     return result;
   }
@@ -101,28 +252,105 @@ class StatefulService {
   StateUpdateResult updateWithoutPropagation(JsonObject& jsonObject, JsonStateUpdater<T> stateUpdater) {
     beginTransaction();
     StateUpdateResult result = stateUpdater(jsonObject, _state);
+    commitUpdate(result);
     endTransaction();
     return result;
   }
 
   void read(std::function<void(T&)> stateReader) {
+    read(stateReader, SnapshotReads());
+  }
+
+  void read(JsonObject& jsonObject, JsonStateReader<T> stateReader) {
+    read(jsonObject, stateReader, SnapshotReads());
+  }
+
+  void readFields(JsonObject& jsonObject, JsonStateFieldReader<T> fieldReader, state_field_mask_t fields) {
+    read([&](T& state) { fieldReader(state, jsonObject, fields); });
+  }
+
+  /**
+   * Serializes the state with the given reader into payload, reusing the payload serialized by an earlier call with the
+   * same reader if the state has not changed since. Returns false, leaving payload untouched, if the state type does
+   * not cache payloads or the reader does not wrap a plain function.
+   */
+  bool readPayload(JsonStateReader<T>& stateReader, String& payload, size_t bufferSize = DEFAULT_BUFFER_SIZE) {
+    typename JsonStateReader<T>::Function key = stateReader.function();
+    if (!StateTraits<T>::payloadCacheCapacity || !key) {
+      return false;
+    }
     beginTransaction();
-    stateReader(_state);
+    uint32_t revision = _revision;
+    bool cached = _payloadCache.load(key, revision, payload);
     endTransaction();
+    if (!cached) {
+      // the state may change while it is serialized, that only makes the payload newer than its revision
+      String serialized;
+      serializePayload(stateReader, serialized, bufferSize);
+      beginTransaction();
+      _payloadCache.store(key, revision, serialized);
+      endTransaction();
+      payload = serialized;
+    }
+    return true;
   }
 
-  void read(JsonObject& jsonObject, JsonStateReader<T> stateReader) {
+  /**
+   * Serializes the state with the given reader into payload, from the payload cache if the state type has one.
+   */
+  void serialize(JsonStateReader<T>& stateReader, String& payload, size_t bufferSize = DEFAULT_BUFFER_SIZE) {
+    if (!readPayload(stateReader, payload, bufferSize)) {
+      serializePayload(stateReader, payload, bufferSize);
+    }
+  }
+
+  /**
+   * Returns the state's revision, which changes with every update that changes the state. The first revision is random
+   * so revisions handed out before a restart are unlikely to match the state after it.
+   */
+  uint32_t getRevision() {
     beginTransaction();
-    stateReader(_state, jsonObject);
+    uint32_t revision = _revision;
     endTransaction();
+    return revision;
   }
 
+  /**
+   * Calls the update handlers with the fields changed since they were last called, all fields are reported for state
+   * types which do not derive from TrackedState.
+   */
   void callUpdateHandlers(const String& originId) {
-    for (const StateUpdateHandlerInfo_t& updateHandler : _updateHandlers) {
-      updateHandler._cb(originId);
+    beginTransaction();
+    state_field_mask_t changedFields = _changedFields ? _changedFields : ALL_STATE_FIELDS;
+    _changedFields = 0;
+    endTransaction();
+    for (uint8_t i = 0; i < _updateHandlerCount; i++) {
+      _updateHandlers[i]._function(_updateHandlers[i]._context, originId, changedFields);
     }
   }
 
+  /**
+   * Queues a call of the update handlers on the PropagationQueue, held until PropagationQueue::release() is called with
+   * heldBy. Returns false if the queue is full.
+   */
+  bool queuePropagation(const char* originId, const void* heldBy) {
+    return PropagationQueue::queue(propagateQueued, this, originId, heldBy);
+  }
+
+  /**
+   * Defers propagation of changes made by update() to ESP8266React::loop(). Updates only mark the service as changed
+   * and the update handlers run once from the loop, at most once every propagationInterval milliseconds, so a burst of
+   * updates results in a single propagation. The propagation carries the origin of the updates, or COALESCED_ORIGIN_ID
+   * if they came from more than one origin.
+   */
+  void deferPropagation(uint32_t propagationInterval = 0) {
+    beginTransaction();
+    _propagationInterval = propagationInterval;
+    _propagatedAt = millis() - propagationInterval;
+    endTransaction();
+    _propagationHook.attach();
+  }
+
  protected:
   T _state;
 
@@ -139,10 +367,148 @@ class StatefulService {
   }
 
  private:
+  typedef std::integral_constant<bool, StateTraits<T>::snapshotReads> SnapshotReads;
+
 #ifdef ESP32
   SemaphoreHandle_t _accessMutex;
 #endif
-  std::list<StateUpdateHandlerInfo_t> _updateHandlers;
+  StateSnapshot<T, SnapshotReads::value> _snapshot;
+  PayloadCache<typename JsonStateReader<T>::Function, StateTraits<T>::payloadCacheCapacity> _payloadCache;
+  StateUpdateHandlerInfo_t _updateHandlers[StateTraits<T>::updateHandlerCapacity];
+  uint8_t _updateHandlerCount;
+  state_field_mask_t _changedFields;
+  uint32_t _revision;
+  LoopHook _propagationHook;
+  uint32_t _propagationInterval;
+  uint32_t _propagatedAt;
+  bool _propagationPending;
+  String _pendingOriginId;
+
+  update_handler_id_t registerUpdateHandler(StateUpdateFunction function,
+                                            void* context,
+                                            StateUpdateCallback* callback,
+                                            bool allowRemove) {
+    if (!function) {
+      return 0;
+    }
+    if (_updateHandlerCount == StateTraits<T>::updateHandlerCapacity) {
+      StateUpdateHandlerInfo_t::refusedCount++;
+      return 0;
+    }
+    StateUpdateHandlerInfo_t& updateHandler = _updateHandlers[_updateHandlerCount++];
+    updateHandler._id = ++StateUpdateHandlerInfo_t::currentUpdatedHandlerId;
+    updateHandler._function = function;
+    updateHandler._context = context;
+    updateHandler._callback = callback;
+    updateHandler._allowRemove = allowRemove;
+    return updateHandler._id;
+  }
+
+  void serializePayload(JsonStateReader<T>& stateReader, String& payload, size_t bufferSize) {
+    PooledJsonDocument jsonDocument(bufferSize);
+    JsonObject jsonObject = jsonDocument.to<JsonObject>();
+    read(jsonObject, stateReader);
+    payload = String();
+    payload.reserve(measureJson(jsonDocument));
+    serializeJson(jsonDocument, payload);
+  }
+
+  static uint32_t initialRevision() {
+#ifdef ESP32
+    return esp_random();
+#elif defined(ESP8266)
+    return ESP.random();
+#endif
+  }
+
+  // must be called with the transaction open
+  void commitUpdate(StateUpdateResult result) {
+    trackChanges(result, std::is_base_of<TrackedState, T>());
+    if (result == StateUpdateResult::CHANGED) {
+      _revision++;
+    }
+    _snapshot.store(_state);
+  }
+
+  void trackChanges(StateUpdateResult result, std::false_type) {
+  }
+
+  void trackChanges(StateUpdateResult result, std::true_type) {
+    state_field_mask_t changedFields = _state.takeChangedFields();
+    if (result == StateUpdateResult::CHANGED) {
+      _changedFields |= changedFields ? changedFields : ALL_STATE_FIELDS;
+    }
+  }
+
+  static void callCallback(void* context, const String& originId, state_field_mask_t changedFields) {
+    (*static_cast<StateUpdateCallback*>(context))(originId);
+  }
+
+  void propagate(const String& originId) {
+    if (!_propagationHook.isAttached()) {
+      callUpdateHandlers(originId);
+      return;
+    }
+    beginTransaction();
+    if (!_propagationPending) {
+      _propagationPending = true;
+      _pendingOriginId = originId;
+    } else if (_pendingOriginId != originId) {
+      _pendingOriginId = COALESCED_ORIGIN_ID;
+    }
+    endTransaction();
+  }
+
+  static void propagatePending(void* context) {
+    StatefulService<T>* service = static_cast<StatefulService<T>*>(context);
+    // only the loop clears the pending flag, so it is safe to check it before taking the lock
+    if (!service->_propagationPending || millis() - service->_propagatedAt < service->_propagationInterval) {
+      return;
+    }
+    service->beginTransaction();
+    String originId = service->_pendingOriginId;
+    service->_propagationPending = false;
+    service->_propagatedAt = millis();
+    service->endTransaction();
+    service->callUpdateHandlers(originId);
+  }
+
+  static void propagateQueued(void* context, const char* originId) {
+    static_cast<StatefulService<T>*>(context)->callUpdateHandlers(originId);
+  }
+
+  void read(std::function<void(T&)>& stateReader, std::false_type) {
+    beginTransaction();
+    stateReader(_state);
+    endTransaction();
+  }
+
+  void read(std::function<void(T&)>& stateReader, std::true_type) {
+    T state;
+    loadSnapshot(state);
+    stateReader(state);
+  }
+
+  void read(JsonObject& jsonObject, JsonStateReader<T>& stateReader, std::false_type) {
+    beginTransaction();
+    stateReader(_state, jsonObject);
+    endTransaction();
+  }
+
+  void read(JsonObject& jsonObject, JsonStateReader<T>& stateReader, std::true_type) {
+    T state;
+    loadSnapshot(state);
+    stateReader(state, jsonObject);
+  }
+
+  void loadSnapshot(T& state) {
+    // fall back to the mutex if the writer was preempted mid-store
+    if (!_snapshot.load(state)) {
+      beginTransaction();
+      state = _state;
+      endTransaction();
+    }
+  }
 };
 
 #endif  // end StatefulService_h
@@ -3,13 +3,22 @@
 SystemStatus::SystemStatus(AsyncWebServer* server, SecurityManager* securityManager) {
   server->on(SYSTEM_STATUS_SERVICE_PATH,
              HTTP_GET,
-             securityManager->wrapRequest(std::bind(&SystemStatus::systemStatus, this, std::placeholders::_1),
-                                          AuthenticationPredicates::IS_AUTHENTICATED));
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&SystemStatus::systemStatus, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_AUTHENTICATED),
+                 RequestPriority::BACKGROUND,
+                 MAX_ESP_STATUS_SIZE));
 }
 
 void SystemStatus::systemStatus(AsyncWebServerRequest* request) {
   AsyncJsonResponse* response = new AsyncJsonResponse(false, MAX_ESP_STATUS_SIZE);
   JsonObject root = response->getRoot();
+  read(this, root);
+  response->setLength();
+  request->send(response);
+}
+
+void SystemStatus::read(void* context, JsonObject& root) {
 #ifdef ESP32
   root["esp_platform"] = "esp32";
   root["max_alloc_heap"] = ESP.getMaxAllocHeap();
@@ -27,6 +36,13 @@ void SystemStatus::systemStatus(AsyncWebServerRequest* request) {
   root["sdk_version"] = ESP.getSdkVersion();
   root["flash_chip_size"] = ESP.getFlashChipSize();
   root["flash_chip_speed"] = ESP.getFlashChipSpeed();
+  root["json_pool_hits"] = JsonDocumentPool::getHits();
+  root["json_pool_misses"] = JsonDocumentPool::getMisses();
+  root["requests_shed_background"] = AdmissionControl::getShed(RequestPriority::BACKGROUND);
+  root["requests_shed_normal"] = AdmissionControl::getShed(RequestPriority::NORMAL);
+  root["propagation_latency_mean"] = PropagationQueue::getMeanLatency();
+  root["propagation_latency_max"] = PropagationQueue::getMaxLatency();
+  root["update_handlers_refused"] = StateUpdateHandlerInfo_t::refusedCount;
 
 // TODO - Ideally this class will take an *FS and extract the file system information from there.
 // ESP8266 and ESP32 do not have feature parity in FS.h which currently makes that difficult.
@@ -39,7 +55,4 @@ void SystemStatus::systemStatus(AsyncWebServerRequest* request) {
   root["fs_total"] = fs_info.totalBytes;
   root["fs_used"] = fs_info.usedBytes;
 #endif
-
-  response->setLength();
-  request->send(response);
 }
@@ -9,11 +9,15 @@
 #include <ESPAsyncTCP.h>
 #endif
 
+#include <AdmissionControl.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
 #include <SecurityManager.h>
 #include <ESPFS.h>
+#include <JsonDocumentPool.h>
+#include <PropagationQueue.h>
+#include <StatefulService.h>
 
 #define MAX_ESP_STATUS_SIZE 1024
 #define SYSTEM_STATUS_SERVICE_PATH "/rest/systemStatus"
@@ -22,6 +26,9 @@ class SystemStatus {
  public:
   SystemStatus(AsyncWebServer* server, SecurityManager* securityManager);
 
+  // writes the status to root, also used to serve the status from the batch endpoint
+  static void read(void* context, JsonObject& root);
+
  private:
   void systemStatus(AsyncWebServerRequest* request);
 };
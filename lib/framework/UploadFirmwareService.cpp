@@ -27,9 +27,11 @@ void UploadFirmwareService::handleUpload(AsyncWebServerRequest* request,
   if (!index) {
     Authentication authentication = _securityManager->authenticateRequest(request);
     if (AuthenticationPredicates::IS_ADMIN(authentication)) {
+      // save pending changes before the flash is taken over by the update
+      WriteBehind::flushAll();
       if (Update.begin(request->contentLength())) {
         // success, let's make sure we end the update if the client hangs up
-        request->onDisconnect(UploadFirmwareService::handleEarlyDisconnect);
+        AdmissionControl::onDisconnect(request, UploadFirmwareService::handleEarlyDisconnect);
       } else {
         // failed to begin, send an error response
         Update.printError(Serial);
@@ -59,7 +61,7 @@ void UploadFirmwareService::handleUpload(AsyncWebServerRequest* request,
 void UploadFirmwareService::uploadComplete(AsyncWebServerRequest* request) {
   // if no error, send the success response
   if (!request->_tempObject) {
-    request->onDisconnect(RestartService::restartNow);
+    AdmissionControl::onDisconnect(request, RestartService::restartNow);
     AsyncWebServerResponse* response = request->beginResponse(200);
     request->send(response);
   }
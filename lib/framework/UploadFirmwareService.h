@@ -13,6 +13,7 @@
 #endif
 
 #include <ESPAsyncWebServer.h>
+#include <AdmissionControl.h>
 #include <SecurityManager.h>
 #include <RestartService.h>
 
@@ -0,0 +1,268 @@
+#include <WebSocketHub.h>
+
+static_assert(WEB_SOCKET_HUB_MAX_CHANNELS <= 32, "Channels are tracked in 32 bit masks");
+
+WebSocketHub::WebSocketHub(AsyncWebServer* server,
+                           SecurityManager* securityManager,
+                           AuthenticationPredicate authenticationPredicate) :
+    _securityManager(securityManager),
+    _webSocket(WEB_SOCKET_HUB_PATH),
+#ifdef ESP32
+    _accessMutex(xSemaphoreCreateRecursiveMutex()),
+#endif
+    _channelCount(0),
+    _maxBufferSize(0),
+    _clientCount(0),
+    _queues(&_webSocket),
+    _loopHook(sendDrained, this) {
+  _loopHook.attach();
+  _webSocket.setFilter(securityManager->filterRequest(authenticationPredicate));
+  _webSocket.onEvent(std::bind(&WebSocketHub::onWSEvent,
+                               this,
+                               std::placeholders::_1,
+                               std::placeholders::_2,
+                               std::placeholders::_3,
+                               std::placeholders::_4,
+                               std::placeholders::_5,
+                               std::placeholders::_6));
+  server->addHandler(&_webSocket);
+  server->on(WEB_SOCKET_HUB_PATH, HTTP_GET, std::bind(&WebSocketHub::forbidden, this, std::placeholders::_1));
+}
+
+WebSocketHub::~WebSocketHub() {
+  for (uint8_t i = 0; i < _channelCount; i++) {
+    _channels[i].release(_channels[i].context);
+  }
+}
+
+uint8_t WebSocketHub::getSubscribers(const char* name) {
+  int8_t channel = findChannel(name);
+  uint8_t subscribers = 0;
+  beginTransaction();
+  for (uint8_t i = 0; channel >= 0 && i < _clientCount; i++) {
+    if (_clients[i].subscribed & ((uint32_t)1 << channel)) {
+      subscribers++;
+    }
+  }
+  endTransaction();
+  return subscribers;
+}
+
+void WebSocketHub::onWSEvent(AsyncWebSocket* server,
+                             AsyncWebSocketClient* client,
+                             AwsEventType type,
+                             void* arg,
+                             uint8_t* data,
+                             size_t len) {
+  if (type == WS_EVT_CONNECT) {
+    connect(client, static_cast<AsyncWebServerRequest*>(arg));
+  } else if (type == WS_EVT_DISCONNECT) {
+    disconnect(client);
+  } else if (type == WS_EVT_DATA) {
+    AwsFrameInfo* info = (AwsFrameInfo*)arg;
+    if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
+      receive(client, (char*)data);
+    }
+  }
+}
+
+void WebSocketHub::connect(AsyncWebSocketClient* client, AsyncWebServerRequest* request) {
+  // the channels a client may use are settled once, when it authenticates
+  Authentication authentication = request ? _securityManager->authenticateRequest(request) : Authentication();
+  uint32_t permitted = 0;
+  for (uint8_t i = 0; i < _channelCount; i++) {
+    if (_channels[i].authenticationPredicate(authentication)) {
+      permitted |= (uint32_t)1 << i;
+    }
+  }
+  beginTransaction();
+  bool full = _clientCount == WEB_SOCKET_HUB_MAX_CLIENTS || !_queues.connect(client->id());
+  if (!full) {
+    _clients[_clientCount++] = {client->id(), permitted, 0};
+  }
+  endTransaction();
+  if (full) {
+    client->close(WEB_SOCKET_TRY_AGAIN_LATER);
+    return;
+  }
+  transmitId(client);
+}
+
+void WebSocketHub::disconnect(AsyncWebSocketClient* client) {
+  beginTransaction();
+  Client* entry = find(client->id());
+  if (entry) {
+    *entry = _clients[--_clientCount];
+  }
+  endTransaction();
+  _queues.disconnect(client->id());
+}
+
+void WebSocketHub::receive(AsyncWebSocketClient* client, char* message) {
+  // a shed client is closed, it reconnects and subscribes again once the heap has recovered
+  size_t capacity = _maxBufferSize + JSON_OBJECT_SIZE(3);
+  if (!AdmissionControl::admit(RequestPriority::NORMAL, capacity)) {
+    client->close(WEB_SOCKET_TRY_AGAIN_LATER);
+    return;
+  }
+  PooledJsonDocument jsonDocument(capacity);
+  DeserializationError error = deserializeJson(jsonDocument, message);
+  const char* type = jsonDocument["type"];
+  const char* name = jsonDocument["channel"];
+  if (error || !type || !name) {
+    AdmissionControl::release(capacity);
+    return;
+  }
+  int8_t channel = findChannel(name);
+  beginTransaction();
+  Client* entry = find(client->id());
+  uint32_t permitted = entry ? entry->permitted : 0;
+  endTransaction();
+  if (channel < 0) {
+    transmitError(client, name, "unknown channel");
+  } else if (!(permitted & ((uint32_t)1 << channel))) {
+    transmitError(client, name, "forbidden");
+  } else if (!strcmp(type, WEB_SOCKET_HUB_SUBSCRIBE_TYPE)) {
+    beginTransaction();
+    entry = find(client->id());
+    if (entry) {
+      entry->subscribed |= (uint32_t)1 << channel;
+    }
+    endTransaction();
+    transmit(channel, WEB_SOCKET_ORIGIN, client);
+  } else if (!strcmp(type, WEB_SOCKET_HUB_UNSUBSCRIBE_TYPE)) {
+    beginTransaction();
+    entry = find(client->id());
+    if (entry) {
+      entry->subscribed &= ~((uint32_t)1 << channel);
+    }
+    endTransaction();
+  } else if (!strcmp(type, WEB_SOCKET_PAYLOAD_TYPE) && jsonDocument["payload"].is<JsonObject>()) {
+    JsonObject payload = jsonDocument["payload"];
+    _channels[channel].update(
+        _channels[channel].context, payload, WEB_SOCKET_ORIGIN_CLIENT_ID_PREFIX + String(client->id()));
+  }
+  AdmissionControl::release(capacity);
+}
+
+void WebSocketHub::transmit(uint8_t channel, const String& originId, AsyncWebSocketClient* destination) {
+  uint32_t mask = (uint32_t)1 << channel;
+  if (!destination) {
+    bool subscribed = false;
+    beginTransaction();
+    for (uint8_t i = 0; i < _clientCount && !subscribed; i++) {
+      subscribed = _clients[i].subscribed & mask;
+    }
+    endTransaction();
+    if (!subscribed) {
+      return;
+    }
+  }
+
+  // the payload is serialized once and embedded as it is
+  String payload;
+  _channels[channel].read(_channels[channel].context, payload);
+  PooledJsonDocument jsonDocument(JSON_OBJECT_SIZE(4) + originId.length() + 1);
+  JsonObject root = jsonDocument.to<JsonObject>();
+  root["type"] = WEB_SOCKET_PAYLOAD_TYPE;
+  root["channel"] = _channels[channel].name;
+  root["origin_id"] = originId;
+  root["payload"] = serialized(payload.c_str(), payload.length());
+
+  size_t len = measureJson(jsonDocument);
+  AsyncWebSocketMessageBuffer* buffer = _webSocket.makeBuffer(len);
+  if (!buffer) {
+    return;
+  }
+  serializeJson(jsonDocument, (char*)buffer->get(), len + 1);
+  if (destination) {
+    destination->text(buffer);
+    return;
+  }
+  // held until it has been queued for every subscriber
+  buffer->lock();
+  beginTransaction();
+  for (uint8_t i = 0; i < _clientCount; i++) {
+    AsyncWebSocketClient* client = (_clients[i].subscribed & mask) ? _webSocket.client(_clients[i].id) : nullptr;
+    if (client) {
+      _queues.send(client, buffer, mask);
+    }
+  }
+  endTransaction();
+  buffer->unlock();
+}
+
+// sends the latest state of the channels they missed to the subscribers which fell behind and have caught up since
+void WebSocketHub::sendDrained(void* context) {
+  WebSocketHub* hub = static_cast<WebSocketHub*>(context);
+  AsyncWebSocketClient* client;
+  uint32_t missed;
+  while ((client = hub->_queues.takeDrained(&missed))) {
+    hub->beginTransaction();
+    Client* entry = hub->find(client->id());
+    missed &= entry ? entry->subscribed : 0;
+    hub->endTransaction();
+    size_t capacity = hub->_maxBufferSize + JSON_OBJECT_SIZE(4);
+    if (missed && !AdmissionControl::admit(RequestPriority::NORMAL, capacity)) {
+      client->close(WEB_SOCKET_TRY_AGAIN_LATER);
+      continue;
+    }
+    for (uint8_t channel = 0; channel < hub->_channelCount; channel++) {
+      if (missed & ((uint32_t)1 << channel)) {
+        hub->transmit(channel, COALESCED_ORIGIN_ID, client);
+      }
+    }
+    if (missed) {
+      AdmissionControl::release(capacity);
+    }
+  }
+}
+
+void WebSocketHub::transmitId(AsyncWebSocketClient* client) {
+  PooledJsonDocument jsonDocument(WEB_SOCKET_CLIENT_ID_MSG_SIZE);
+  JsonObject root = jsonDocument.to<JsonObject>();
+  root["type"] = "id";
+  root["id"] = WEB_SOCKET_ORIGIN_CLIENT_ID_PREFIX + String(client->id());
+  send(client, jsonDocument);
+}
+
+void WebSocketHub::transmitError(AsyncWebSocketClient* client, const char* channel, const char* error) {
+  PooledJsonDocument jsonDocument(JSON_OBJECT_SIZE(3));
+  JsonObject root = jsonDocument.to<JsonObject>();
+  root["type"] = WEB_SOCKET_HUB_ERROR_TYPE;
+  root["channel"] = channel;
+  root["error"] = error;
+  send(client, jsonDocument);
+}
+
+void WebSocketHub::send(AsyncWebSocketClient* client, JsonDocument& jsonDocument) {
+  size_t len = measureJson(jsonDocument);
+  AsyncWebSocketMessageBuffer* buffer = _webSocket.makeBuffer(len);
+  if (buffer) {
+    serializeJson(jsonDocument, (char*)buffer->get(), len + 1);
+    client->text(buffer);
+  }
+}
+
+// must be called with the transaction open
+WebSocketHub::Client* WebSocketHub::find(uint32_t id) {
+  for (uint8_t i = 0; i < _clientCount; i++) {
+    if (_clients[i].id == id) {
+      return &_clients[i];
+    }
+  }
+  return nullptr;
+}
+
+int8_t WebSocketHub::findChannel(const char* name) {
+  for (uint8_t i = 0; i < _channelCount; i++) {
+    if (!strcmp(_channels[i].name, name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void WebSocketHub::forbidden(AsyncWebServerRequest* request) {
+  request->send(403);
+}
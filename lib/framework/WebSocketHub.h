@@ -0,0 +1,206 @@
+#ifndef WebSocketHub_h
+#define WebSocketHub_h
+
+#include <ESPAsyncWebServer.h>
+
+#include <AdmissionControl.h>
+#include <LoopHook.h>
+#include <SecurityManager.h>
+#include <StatefulService.h>
+#include <WebSocketTxRx.h>
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
+
+#define WEB_SOCKET_HUB_PATH "/ws/hub"
+
+#define WEB_SOCKET_HUB_SUBSCRIBE_TYPE "subscribe"
+#define WEB_SOCKET_HUB_UNSUBSCRIBE_TYPE "unsubscribe"
+#define WEB_SOCKET_HUB_ERROR_TYPE "error"
+
+#ifndef WEB_SOCKET_HUB_MAX_CHANNELS
+#define WEB_SOCKET_HUB_MAX_CHANNELS 16
+#endif
+
+// clients connected at once, further clients are closed with 1013 (try again later)
+#ifndef WEB_SOCKET_HUB_MAX_CLIENTS
+#define WEB_SOCKET_HUB_MAX_CLIENTS 8
+#endif
+
+typedef void (*HubReadFunction)(void* context, String& payload);
+typedef StateUpdateResult (*HubUpdateFunction)(void* context, JsonObject& root, const String& originId);
+typedef void (*HubContextFunction)(void* context);
+
+/**
+ * Serves many services over one WebSocket, so a page following several services holds one connection and
+ * authenticates once rather than once for each service.
+ *
+ * StatefulServices are registered as named channels, each with the predicate a client must satisfy to use it. Clients
+ * send {"type":"subscribe","channel":"lightState"} to receive the channel's state, followed by its changes, and
+ * {"type":"unsubscribe","channel":"lightState"} to stop. {"type":"payload","channel":"lightState","payload":{...}}
+ * updates the service. Every message the hub sends carries the channel it belongs to:
+ *
+ * {"type":"payload","channel":"lightState","origin_id":"websocket:3","payload":{"led_on":true}}
+ *
+ * A change is serialized once, from the service's payload cache where it has one, and sent to each subscribed client.
+ * Each channel is a stream of the hub's WebSocketQueues, so a subscriber over its queue budget is sent only the latest
+ * state of the channels it missed once it has caught up.
+ */
+class WebSocketHub {
+ public:
+  // addChannel() registers an update handler on the channel's service
+  static const uint8_t updateHandlersPerChannel = 1;
+
+  WebSocketHub(AsyncWebServer* server,
+               SecurityManager* securityManager,
+               AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_AUTHENTICATED);
+  ~WebSocketHub();
+
+  /**
+   * Registers a StatefulService as a channel, read and updated with the given reader and updater like a
+   * WebSocketTxRx. Returns false if WEB_SOCKET_HUB_MAX_CHANNELS channels are already registered or the service can
+   * hold no more update handlers.
+   */
+  template <class T>
+  bool addChannel(const char* name,
+                  StatefulService<T>* statefulService,
+                  typename NonDeduced<JsonStateReader<T>>::type stateReader,
+                  typename NonDeduced<JsonStateUpdater<T>>::type stateUpdater,
+                  AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_ADMIN,
+                  size_t bufferSize = DEFAULT_BUFFER_SIZE) {
+    if (_channelCount == WEB_SOCKET_HUB_MAX_CHANNELS) {
+      return false;
+    }
+    ChannelBinding<T>* binding =
+        new ChannelBinding<T>(this, _channelCount, statefulService, stateReader, stateUpdater, bufferSize);
+    if (!statefulService->addUpdateHandler(ChannelBinding<T>::changed, binding, false)) {
+      delete binding;
+      return false;
+    }
+    _channels[_channelCount++] = {name,
+                                  ChannelBinding<T>::read,
+                                  ChannelBinding<T>::update,
+                                  ChannelBinding<T>::release,
+                                  binding,
+                                  bufferSize,
+                                  authenticationPredicate};
+    if (bufferSize > _maxBufferSize) {
+      _maxBufferSize = bufferSize;
+    }
+    return true;
+  }
+
+  // the number of clients subscribed to the named channel
+  uint8_t getSubscribers(const char* name);
+
+ private:
+  template <class T>
+  class ChannelBinding {
+   public:
+    ChannelBinding(WebSocketHub* hub,
+                   uint8_t channel,
+                   StatefulService<T>* statefulService,
+                   JsonStateReader<T> stateReader,
+                   JsonStateUpdater<T> stateUpdater,
+                   size_t bufferSize) :
+        _hub(hub),
+        _channel(channel),
+        _statefulService(statefulService),
+        _stateReader(stateReader),
+        _stateUpdater(stateUpdater),
+        _bufferSize(bufferSize) {
+    }
+
+    static void read(void* context, String& payload) {
+      ChannelBinding* binding = static_cast<ChannelBinding*>(context);
+      binding->_statefulService->serialize(binding->_stateReader, payload, binding->_bufferSize);
+    }
+
+    static StateUpdateResult update(void* context, JsonObject& root, const String& originId) {
+      ChannelBinding* binding = static_cast<ChannelBinding*>(context);
+      return binding->_statefulService->update(root, binding->_stateUpdater, originId);
+    }
+
+    static void changed(void* context, const String& originId, state_field_mask_t changedFields) {
+      ChannelBinding* binding = static_cast<ChannelBinding*>(context);
+      binding->_hub->transmit(binding->_channel, originId);
+    }
+
+    static void release(void* context) {
+      delete static_cast<ChannelBinding*>(context);
+    }
+
+   private:
+    WebSocketHub* _hub;
+    uint8_t _channel;
+    StatefulService<T>* _statefulService;
+    JsonStateReader<T> _stateReader;
+    JsonStateUpdater<T> _stateUpdater;
+    size_t _bufferSize;
+  };
+
+  struct Channel {
+    const char* name;
+    HubReadFunction read;
+    HubUpdateFunction update;
+    HubContextFunction release;
+    void* context;
+    size_t bufferSize;
+    AuthenticationPredicate authenticationPredicate;
+  };
+
+  // channels are tracked in 32 bit masks
+  struct Client {
+    uint32_t id;
+    uint32_t permitted;
+    uint32_t subscribed;
+  };
+
+  SecurityManager* _securityManager;
+  AsyncWebSocket _webSocket;
+#ifdef ESP32
+  SemaphoreHandle_t _accessMutex;
+#endif
+  Channel _channels[WEB_SOCKET_HUB_MAX_CHANNELS];
+  uint8_t _channelCount;
+  size_t _maxBufferSize;
+  Client _clients[WEB_SOCKET_HUB_MAX_CLIENTS];
+  uint8_t _clientCount;
+  WebSocketQueues _queues;
+  LoopHook _loopHook;
+
+  static void sendDrained(void* context);
+
+  void onWSEvent(AsyncWebSocket* server,
+                 AsyncWebSocketClient* client,
+                 AwsEventType type,
+                 void* arg,
+                 uint8_t* data,
+                 size_t len);
+  void connect(AsyncWebSocketClient* client, AsyncWebServerRequest* request);
+  void disconnect(AsyncWebSocketClient* client);
+  void receive(AsyncWebSocketClient* client, char* message);
+  void transmit(uint8_t channel, const String& originId, AsyncWebSocketClient* destination = nullptr);
+  void transmitId(AsyncWebSocketClient* client);
+  void transmitError(AsyncWebSocketClient* client, const char* channel, const char* error);
+  void send(AsyncWebSocketClient* client, JsonDocument& jsonDocument);
+  Client* find(uint32_t id);
+  int8_t findChannel(const char* name);
+  void forbidden(AsyncWebServerRequest* request);
+
+  inline void beginTransaction() {
+#ifdef ESP32
+    xSemaphoreTakeRecursive(_accessMutex, portMAX_DELAY);
+#endif
+  }
+
+  inline void endTransaction() {
+#ifdef ESP32
+    xSemaphoreGiveRecursive(_accessMutex);
+#endif
+  }
+};
+
+#endif  // end WebSocketHub_h
@@ -0,0 +1,165 @@
+#include <WebSocketStats.h>
+#include <JsonDocumentPool.h>
+
+WebSocketQueues* WebSocketQueues::_first = nullptr;
+
+WebSocketQueues::WebSocketQueues(AsyncWebSocket* webSocket) :
+    _webSocket(webSocket),
+    _next(_first),
+#ifdef ESP32
+    _accessMutex(xSemaphoreCreateMutex()),
+#endif
+    _count(0),
+    _stale(0) {
+  _first = this;
+}
+
+WebSocketQueues::~WebSocketQueues() {
+  for (WebSocketQueues** queues = &_first; *queues; queues = &(*queues)->_next) {
+    if (*queues == this) {
+      *queues = _next;
+      break;
+    }
+  }
+}
+
+bool WebSocketQueues::connect(uint32_t id) {
+  beginTransaction();
+  bool full = _count == WEB_SOCKET_MAX_CLIENTS;
+  if (!full) {
+    _clients[_count++] = {id, 0, 0};
+  }
+  endTransaction();
+  return !full;
+}
+
+void WebSocketQueues::disconnect(uint32_t id) {
+  beginTransaction();
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_clients[i].id == id) {
+      if (_clients[i].missed) {
+        _stale--;
+      }
+      _clients[i] = _clients[--_count];
+      break;
+    }
+  }
+  endTransaction();
+}
+
+void WebSocketQueues::broadcast(AsyncWebSocketMessageBuffer* buffer) {
+  // held until it has been queued for every client
+  buffer->lock();
+  beginTransaction();
+  for (uint8_t i = 0; i < _count; i++) {
+    AsyncWebSocketClient* client = _webSocket->client(_clients[i].id);
+    if (client) {
+      send(_clients[i], client, buffer, 1);
+    }
+  }
+  endTransaction();
+  buffer->unlock();
+}
+
+void WebSocketQueues::send(AsyncWebSocketClient* client, AsyncWebSocketMessageBuffer* buffer, uint32_t stream) {
+  beginTransaction();
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_clients[i].id == client->id()) {
+      send(_clients[i], client, buffer, stream);
+      break;
+    }
+  }
+  endTransaction();
+}
+
+void WebSocketQueues::send(Client& entry,
+                           AsyncWebSocketClient* client,
+                           AsyncWebSocketMessageBuffer* buffer,
+                           uint32_t stream) {
+  if ((entry.missed & stream) || client->queueLength() >= WEB_SOCKET_QUEUE_BUDGET) {
+    // superseded by the latest state, which is sent once the client has caught up
+    if (!entry.missed) {
+      _stale++;
+    }
+    entry.missed |= stream;
+    entry.dropped++;
+  } else {
+    client->text(buffer);
+  }
+}
+
+AsyncWebSocketClient* WebSocketQueues::takeDrained(uint32_t* missed) {
+  // only the loop clears stale clients, so the count may be checked before taking the lock
+  if (!_stale) {
+    return nullptr;
+  }
+  AsyncWebSocketClient* drained = nullptr;
+  beginTransaction();
+  for (uint8_t i = 0; i < _count && !drained; i++) {
+    AsyncWebSocketClient* client = _clients[i].missed ? _webSocket->client(_clients[i].id) : nullptr;
+    if (client && client->queueLength() < WEB_SOCKET_QUEUE_BUDGET) {
+      if (missed) {
+        *missed = _clients[i].missed;
+      }
+      _clients[i].missed = 0;
+      _stale--;
+      drained = client;
+    }
+  }
+  endTransaction();
+  return drained;
+}
+
+void WebSocketQueues::read(JsonObject& root) {
+  root["path"] = _webSocket->url();
+  JsonArray clients = root.createNestedArray("clients");
+  beginTransaction();
+  for (uint8_t i = 0; i < _count; i++) {
+    AsyncWebSocketClient* client = _webSocket->client(_clients[i].id);
+    JsonObject entry = clients.createNestedObject();
+    entry["id"] = _clients[i].id;
+    entry["queued"] = client ? client->queueLength() : 0;
+    entry["dropped"] = _clients[i].dropped;
+    entry["stale"] = _clients[i].missed != 0;
+  }
+  endTransaction();
+}
+
+size_t WebSocketQueues::count() {
+  size_t count = 0;
+  for (WebSocketQueues* queues = _first; queues; queues = queues->_next) {
+    count++;
+  }
+  return count;
+}
+
+void WebSocketQueues::readAll(JsonArray& sockets) {
+  for (WebSocketQueues* queues = _first; queues; queues = queues->_next) {
+    JsonObject socket = sockets.createNestedObject();
+    queues->read(socket);
+  }
+}
+
+WebSocketStats::WebSocketStats(AsyncWebServer* server, SecurityManager* securityManager) {
+  server->on(WEB_SOCKET_STATS_SERVICE_PATH,
+             HTTP_GET,
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&WebSocketStats::webSocketStats, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_AUTHENTICATED),
+                 RequestPriority::BACKGROUND,
+                 MAX_WEB_SOCKET_STATS_SIZE));
+}
+
+void WebSocketStats::webSocketStats(AsyncWebServerRequest* request) {
+  // socket paths are not copied, clients may connect while the response is built so it is sized for a full table
+  size_t count = WebSocketQueues::count();
+  PooledJsonDocument jsonDocument(
+      JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(count) +
+      count * (JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(WEB_SOCKET_MAX_CLIENTS) +
+               WEB_SOCKET_MAX_CLIENTS * JSON_OBJECT_SIZE(4)));
+  JsonArray sockets = jsonDocument.createNestedArray("sockets");
+  WebSocketQueues::readAll(sockets);
+  String payload;
+  serializeJson(jsonDocument, payload);
+  request->send(200, JSON_MIMETYPE, payload);
+}
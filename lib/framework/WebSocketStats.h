@@ -0,0 +1,120 @@
+#ifndef WebSocketStats_h
+#define WebSocketStats_h
+
+#ifdef ESP32
+#include <WiFi.h>
+#include <AsyncTCP.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#include <ESPAsyncTCP.h>
+#endif
+
+#include <AdmissionControl.h>
+#include <ArduinoJson.h>
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+#include <SecurityManager.h>
+
+#define WEB_SOCKET_STATS_SERVICE_PATH "/rest/webSocketStats"
+
+// reserved when admitting a request, the response itself grows with the number of sockets and clients
+#define MAX_WEB_SOCKET_STATS_SIZE 1024
+
+// messages a client may have queued before the state broadcast to it is held back, below WS_MAX_QUEUED_MESSAGES
+#ifndef WEB_SOCKET_QUEUE_BUDGET
+#define WEB_SOCKET_QUEUE_BUDGET 4
+#endif
+
+// clients tracked for each socket, further clients are closed with 1013 (try again later)
+#ifndef WEB_SOCKET_MAX_CLIENTS
+#define WEB_SOCKET_MAX_CLIENTS 8
+#endif
+
+/**
+ * Send queue accounting for the clients of a single socket, so a client on a slow link can not make the socket queue
+ * messages until the heap runs out.
+ *
+ * State is sent to each client with room in its queue. A client with WEB_SOCKET_QUEUE_BUDGET or more messages queued
+ * is marked stale instead and the message is counted as dropped for it, as is every later message until its queue has
+ * drained. It is then sent the latest state in place of everything it missed.
+ *
+ * A socket carrying several states, such as the WebSocketHub's channels, tells them apart as streams, each a bit in a
+ * 32 bit mask. A stale client is then only sent the latest state of the streams it missed.
+ *
+ * Every instance is kept in a list so WebSocketStats can report on them all.
+ */
+class WebSocketQueues {
+ public:
+  WebSocketQueues(AsyncWebSocket* webSocket);
+  ~WebSocketQueues();
+
+  // returns false if WEB_SOCKET_MAX_CLIENTS clients are already tracked
+  bool connect(uint32_t id);
+  void disconnect(uint32_t id);
+
+  // sends the state message to every client with room for it and marks the others stale
+  void broadcast(AsyncWebSocketMessageBuffer* buffer);
+
+  // sends a message of the stream to the client if it has room for it, otherwise marks the stream stale for it
+  void send(AsyncWebSocketClient* client, AsyncWebSocketMessageBuffer* buffer, uint32_t stream);
+
+  /**
+   * Returns a stale client with room for the latest state again, which is no longer marked stale, or nullptr. The
+   * streams it missed are written to missed if given.
+   */
+  AsyncWebSocketClient* takeDrained(uint32_t* missed = nullptr);
+
+  void read(JsonObject& root);
+
+  static size_t count();
+  static void readAll(JsonArray& sockets);
+
+ private:
+  struct Client {
+    uint32_t id;
+    uint32_t dropped;
+    // the streams the client is stale for
+    uint32_t missed;
+  };
+
+  static WebSocketQueues* _first;
+
+  AsyncWebSocket* _webSocket;
+  WebSocketQueues* _next;
+#ifdef ESP32
+  SemaphoreHandle_t _accessMutex;
+#endif
+  Client _clients[WEB_SOCKET_MAX_CLIENTS];
+  uint8_t _count;
+  uint8_t _stale;
+
+  // must be called with the transaction open
+  void send(Client& entry, AsyncWebSocketClient* client, AsyncWebSocketMessageBuffer* buffer, uint32_t stream);
+
+  inline void beginTransaction() {
+#ifdef ESP32
+    xSemaphoreTake(_accessMutex, portMAX_DELAY);
+#endif
+  }
+
+  inline void endTransaction() {
+#ifdef ESP32
+    xSemaphoreGive(_accessMutex);
+#endif
+  }
+};
+
+/**
+ * Reports the queue depth and the broadcasts dropped for each client of each WebSocketTx.
+ */
+class WebSocketStats {
+ public:
+  WebSocketStats(AsyncWebServer* server, SecurityManager* securityManager);
+
+ private:
+  void webSocketStats(AsyncWebServerRequest* request);
+};
+
+#endif  // end WebSocketStats_h
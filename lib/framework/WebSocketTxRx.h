@@ -1,22 +1,38 @@
 #ifndef WebSocketTxRx_h
 #define WebSocketTxRx_h
 
+#include <AdmissionControl.h>
+#include <JsonUtils.h>
 #include <StatefulService.h>
 #include <ESPAsyncWebServer.h>
 #include <SecurityManager.h>
+#include <WebSocketStats.h>
 
 #define WEB_SOCKET_CLIENT_ID_MSG_SIZE 128
 
 #define WEB_SOCKET_ORIGIN "websocket"
+#define WEB_SOCKET_PAYLOAD_TYPE "payload"
+#define WEB_SOCKET_PATCH_TYPE "patch"
+#define WEB_SOCKET_RESYNC_TYPE "resync"
 #define WEB_SOCKET_ORIGIN_CLIENT_ID_PREFIX "websocket:"
 
+// the close code asking a client which was shed to reconnect later
+#define WEB_SOCKET_TRY_AGAIN_LATER 1013
+
 template <class T>
 class WebSocketConnector {
+ public:
+  // connections and frames are shed when the heap is low unless they have CONTROL priority, NORMAL by default
+  void setPriority(RequestPriority priority) {
+    _admission.priority = priority;
+  }
+
  protected:
   StatefulService<T>* _statefulService;
   AsyncWebServer* _server;
   AsyncWebSocket _webSocket;
   size_t _bufferSize;
+  AdmissionPolicy _admission;
 
   WebSocketConnector(StatefulService<T>* statefulService,
                      AsyncWebServer* server,
@@ -24,7 +40,11 @@ class WebSocketConnector {
                      SecurityManager* securityManager,
                      AuthenticationPredicate authenticationPredicate,
                      size_t bufferSize) :
-      _statefulService(statefulService), _server(server), _webSocket(webSocketPath), _bufferSize(bufferSize) {
+      _statefulService(statefulService),
+      _server(server),
+      _webSocket(webSocketPath),
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
     _webSocket.setFilter(securityManager->filterRequest(authenticationPredicate));
     _webSocket.onEvent(std::bind(&WebSocketConnector::onWSEvent,
                                  this,
@@ -42,7 +62,11 @@ class WebSocketConnector {
                      AsyncWebServer* server,
                      char const* webSocketPath,
                      size_t bufferSize) :
-      _statefulService(statefulService), _server(server), _webSocket(webSocketPath), _bufferSize(bufferSize) {
+      _statefulService(statefulService),
+      _server(server),
+      _webSocket(webSocketPath),
+      _bufferSize(bufferSize),
+      _admission{RequestPriority::NORMAL, bufferSize} {
     _webSocket.onEvent(std::bind(&WebSocketConnector::onWSEvent,
                                  this,
                                  std::placeholders::_1,
@@ -65,6 +89,32 @@ class WebSocketConnector {
     return WEB_SOCKET_ORIGIN_CLIENT_ID_PREFIX + String(client->id());
   }
 
+  // a shed client is closed, it reconnects and is sent the current state once the heap has recovered
+  bool admit(AsyncWebSocketClient* client) {
+    if (AdmissionControl::admit(_admission.priority, _admission.reserve)) {
+      return true;
+    }
+    client->close(WEB_SOCKET_TRY_AGAIN_LATER);
+    return false;
+  }
+
+  void release() {
+    AdmissionControl::release(_admission.reserve);
+  }
+
+  // whether the frame is {"type":"resync"}, sent by a client holding a revision a patch does not apply to
+  static bool isResync(void* arg, uint8_t* data, size_t len) {
+    AwsFrameInfo* info = (AwsFrameInfo*)arg;
+    // anything longer is an update, which is left to the receiver to parse
+    if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT || len > 32) {
+      return false;
+    }
+    PooledJsonDocument jsonDocument(JSON_OBJECT_SIZE(1) + len);
+    DeserializationError error = deserializeJson(jsonDocument, (const char*)data, len);
+    const char* type = jsonDocument["type"];
+    return !error && jsonDocument.size() == 1 && type && !strcmp(type, WEB_SOCKET_RESYNC_TYPE);
+  }
+
  private:
   void forbidden(AsyncWebServerRequest* request) {
     request->send(403);
@@ -74,6 +124,9 @@ class WebSocketConnector {
 template <class T>
 class WebSocketTx : virtual public WebSocketConnector<T> {
  public:
+  // one update handler is registered on the service for the broadcasts
+  static const uint8_t updateHandlerCount = 1;
+
   WebSocketTx(JsonStateReader<T> stateReader,
               StatefulService<T>* statefulService,
               AsyncWebServer* server,
@@ -87,9 +140,19 @@ class WebSocketTx : virtual public WebSocketConnector<T> {
                             securityManager,
                             authenticationPredicate,
                             bufferSize),
-      _stateReader(stateReader) {
+      _stateReader(stateReader),
+      _deltas(false),
+      _snapshotRevision(0),
+      _broadcastRevision(0),
+      _queues(&this->_webSocket),
+      _loopHook(sendDrained, this) {
+    _loopHook.attach();
     WebSocketConnector<T>::_statefulService->addUpdateHandler(
-        [&](const String& originId) { transmitData(nullptr, originId); }, false);
+        [](void* context, const String& originId, state_field_mask_t changedFields) {
+          static_cast<WebSocketTx<T>*>(context)->transmitData(nullptr, originId, changedFields);
+        },
+        this,
+        false);
   }
 
   WebSocketTx(JsonStateReader<T> stateReader,
@@ -97,9 +160,37 @@ class WebSocketTx : virtual public WebSocketConnector<T> {
               AsyncWebServer* server,
               char const* webSocketPath,
               size_t bufferSize = DEFAULT_BUFFER_SIZE) :
-      WebSocketConnector<T>(statefulService, server, webSocketPath, bufferSize), _stateReader(stateReader) {
+      WebSocketConnector<T>(statefulService, server, webSocketPath, bufferSize),
+      _stateReader(stateReader),
+      _deltas(false),
+      _snapshotRevision(0),
+      _broadcastRevision(0),
+      _queues(&this->_webSocket),
+      _loopHook(sendDrained, this) {
+    _loopHook.attach();
     WebSocketConnector<T>::_statefulService->addUpdateHandler(
-        [&](const String& originId) { transmitData(nullptr, originId); }, false);
+        [](void* context, const String& originId, state_field_mask_t changedFields) {
+          static_cast<WebSocketTx<T>*>(context)->transmitData(nullptr, originId, changedFields);
+        },
+        this,
+        false);
+  }
+
+  /**
+   * Sets a reader used to send only the fields changed by an update, as a "patch" message, for state types derived
+   * from TrackedState. Clients are sent the full state when they connect and when all fields have changed.
+   */
+  void setFieldReader(JsonStateFieldReader<T> fieldReader) {
+    _fieldReader = fieldReader;
+  }
+
+  /**
+   * Broadcasts changes as a "patch" message holding a JSON merge patch (RFC 7386) against the state last broadcast,
+   * whenever the patch is the smaller of the two. The last broadcast state is kept to diff against. Unlike a field
+   * reader this works for any state type, and takes the place of one.
+   */
+  void enableDeltas() {
+    _deltas = true;
   }
 
  protected:
@@ -110,26 +201,50 @@ class WebSocketTx : virtual public WebSocketConnector<T> {
                          uint8_t* data,
                          size_t len) {
     if (type == WS_EVT_CONNECT) {
-      // when a client connects, we transmit it's id and the current payload
-      transmitId(client);
+      if (!_queues.connect(client->id())) {
+        client->close(WEB_SOCKET_TRY_AGAIN_LATER);
+      } else if (WebSocketConnector<T>::admit(client)) {
+        // when a client connects, we transmit it's id and the current payload
+        transmitId(client);
+        transmitData(client, WEB_SOCKET_ORIGIN);
+        WebSocketConnector<T>::release();
+      }
+    } else if (type == WS_EVT_DISCONNECT) {
+      _queues.disconnect(client->id());
+    } else if (type == WS_EVT_DATA && WebSocketConnector<T>::isResync(arg, data, len) &&
+               WebSocketConnector<T>::admit(client)) {
       transmitData(client, WEB_SOCKET_ORIGIN);
+      WebSocketConnector<T>::release();
     }
   }
 
  private:
   JsonStateReader<T> _stateReader;
+  JsonStateFieldReader<T> _fieldReader;
+  bool _deltas;
+  String _snapshot;
+  uint32_t _snapshotRevision;
+  // the revision the clients hold, which patches apply to
+  uint32_t _broadcastRevision;
+  WebSocketQueues _queues;
+  LoopHook _loopHook;
+
+  // sends the latest state to the clients which fell behind and have caught up since
+  static void sendDrained(void* context) {
+    WebSocketTx<T>* webSocketTx = static_cast<WebSocketTx<T>*>(context);
+    AsyncWebSocketClient* client;
+    while ((client = webSocketTx->_queues.takeDrained()) && webSocketTx->admit(client)) {
+      webSocketTx->transmitData(client, COALESCED_ORIGIN_ID);
+      webSocketTx->release();
+    }
+  }
 
   void transmitId(AsyncWebSocketClient* client) {
-    DynamicJsonDocument jsonDocument = DynamicJsonDocument(WEB_SOCKET_CLIENT_ID_MSG_SIZE);
+    PooledJsonDocument jsonDocument(WEB_SOCKET_CLIENT_ID_MSG_SIZE);
     JsonObject root = jsonDocument.to<JsonObject>();
     root["type"] = "id";
     root["id"] = WebSocketConnector<T>::clientId(client);
-    size_t len = measureJson(jsonDocument);
-    AsyncWebSocketMessageBuffer* buffer = WebSocketConnector<T>::_webSocket.makeBuffer(len);
-    if (buffer) {
-      serializeJson(jsonDocument, (char*)buffer->get(), len + 1);
-      client->text(buffer);
-    }
+    send(client, jsonDocument);
   }
 
   /**
@@ -138,24 +253,135 @@ class WebSocketTx : virtual public WebSocketConnector<T> {
    *
    * Original implementation sent clients their own IDs so they could ignore updates they initiated. This approach
    * simplifies the client and the server implementation but may not be sufficent for all use-cases.
+   *
+   * If a field reader is set and only some fields have changed, a patch containing just those fields is sent. Full
+   * payloads are taken from the service's payload cache where possible and embedded in the message as they are.
+   *
+   * Every message carries the revision of the state it holds, patches also carry the revision they apply to as "base".
+   * A client holding any other revision has missed a broadcast and asks for the full state with a resync message.
    */
-  void transmitData(AsyncWebSocketClient* client, const String& originId) {
-    DynamicJsonDocument jsonDocument = DynamicJsonDocument(WebSocketConnector<T>::_bufferSize);
+  void transmitData(AsyncWebSocketClient* client,
+                    const String& originId,
+                    state_field_mask_t changedFields = ALL_STATE_FIELDS) {
+    uint32_t revision = WebSocketConnector<T>::_statefulService->getRevision();
+    if (!client && _deltas) {
+      transmitDelta(originId, revision);
+      return;
+    }
+    bool patch = !_deltas && _fieldReader && changedFields != ALL_STATE_FIELDS;
+    String cachedPayload;
+    bool cached = !patch && WebSocketConnector<T>::_statefulService->readPayload(
+                                _stateReader, cachedPayload, WebSocketConnector<T>::_bufferSize);
+    PooledJsonDocument jsonDocument(
+        cached ? JSON_OBJECT_SIZE(4) + originId.length() + 1 : WebSocketConnector<T>::_bufferSize);
     JsonObject root = jsonDocument.to<JsonObject>();
-    root["type"] = "payload";
+    root["type"] = patch ? WEB_SOCKET_PATCH_TYPE : WEB_SOCKET_PAYLOAD_TYPE;
     root["origin_id"] = originId;
-    JsonObject payload = root.createNestedObject("payload");
-    WebSocketConnector<T>::_statefulService->read(payload, _stateReader);
+    root["revision"] = revision;
+    if (patch) {
+      root["base"] = _broadcastRevision;
+    }
+    if (cached) {
+      root["payload"] = serialized(cachedPayload.c_str(), cachedPayload.length());
+    } else {
+      JsonObject payload = root.createNestedObject("payload");
+      if (patch) {
+        WebSocketConnector<T>::_statefulService->readFields(payload, _fieldReader, changedFields);
+      } else {
+        WebSocketConnector<T>::_statefulService->read(payload, _stateReader);
+      }
+    }
+    // a client which is sent the full state while it is the only client leaves no other holding an older revision
+    if (!client || (!patch && WebSocketConnector<T>::_webSocket.count() == 1)) {
+      _broadcastRevision = revision;
+    }
+    send(client, jsonDocument);
+  }
 
+  /**
+   * Broadcasts the merge patch from the last broadcast state, or the full state if that is smaller. The current state
+   * is taken from the payload cache and the patch is worked out in place in the parsed state, so a broadcast takes two
+   * documents the size of the state and the message is serialized straight into the socket's buffer.
+   */
+  void transmitDelta(const String& originId, uint32_t revision) {
+    if (!WebSocketConnector<T>::_webSocket.count()) {
+      // no client holds the last broadcast state, the next broadcast sends the full state
+      _snapshot = String();
+      _broadcastRevision = revision;
+      return;
+    }
+    size_t bufferSize = WebSocketConnector<T>::_bufferSize;
+    String payload;
+    WebSocketConnector<T>::_statefulService->serialize(_stateReader, payload, bufferSize);
+
+    PooledJsonDocument jsonDocument(JSON_OBJECT_SIZE(5) + originId.length() + 1);
+    JsonObject root = jsonDocument.to<JsonObject>();
+    root["type"] = WEB_SOCKET_PATCH_TYPE;
+    root["origin_id"] = originId;
+    root["revision"] = revision;
+    // a client which connected since the snapshot was taken may hold a newer state, which the patch does not apply to
+    bool patch = _snapshot.length() && _snapshotRevision == _broadcastRevision;
+    if (patch) {
+      // the patch names members removed from the state with the previous state's keys, so that is kept until it is sent
+      PooledJsonDocument previousDocument(bufferSize);
+      PooledJsonDocument currentDocument(bufferSize);
+      patch = !deserializeJson(previousDocument, _snapshot.c_str()) &&
+              !deserializeJson(currentDocument, payload.c_str()) && previousDocument.is<JsonObject>() &&
+              currentDocument.is<JsonObject>();
+      if (patch) {
+        JsonObject from = previousDocument.as<JsonObject>();
+        JsonObject delta = currentDocument.as<JsonObject>();
+        patch = JsonUtils::diff(from, delta) && measureJson(delta) < payload.length();
+        if (patch) {
+          root["base"] = _broadcastRevision;
+          send(nullptr, jsonDocument, delta);
+        }
+      }
+    }
+    if (!patch) {
+      root["type"] = WEB_SOCKET_PAYLOAD_TYPE;
+      root["payload"] = serialized(payload.c_str(), payload.length());
+      send(nullptr, jsonDocument);
+    }
+    _snapshot = std::move(payload);
+    _snapshotRevision = revision;
+    _broadcastRevision = revision;
+  }
+
+  // sends the message to the client, or to all clients with room in their queues if none is given
+  void send(AsyncWebSocketClient* client, JsonDocument& jsonDocument) {
     size_t len = measureJson(jsonDocument);
     AsyncWebSocketMessageBuffer* buffer = WebSocketConnector<T>::_webSocket.makeBuffer(len);
     if (buffer) {
       serializeJson(jsonDocument, (char*)buffer->get(), len + 1);
-      if (client) {
-        client->text(buffer);
-      } else {
-        WebSocketConnector<T>::_webSocket.textAll(buffer);
-      }
+      send(client, buffer);
+    }
+  }
+
+  // sends the message with the object, held by another document, added to it as its payload
+  void send(AsyncWebSocketClient* client, JsonDocument& jsonDocument, JsonObject& payload) {
+    static const char payloadMember[] = ",\"payload\":";
+    size_t messageLen = measureJson(jsonDocument);
+    size_t payloadLen = measureJson(payload);
+    // the payload takes the place of the message's closing brace, which follows it
+    size_t len = messageLen + strlen(payloadMember) + payloadLen;
+    AsyncWebSocketMessageBuffer* buffer = WebSocketConnector<T>::_webSocket.makeBuffer(len);
+    if (buffer) {
+      char* data = (char*)buffer->get();
+      serializeJson(jsonDocument, data, messageLen + 1);
+      strcpy(data + messageLen - 1, payloadMember);
+      serializeJson(payload, data + messageLen - 1 + strlen(payloadMember), payloadLen + 1);
+      data[len - 1] = '}';
+      data[len] = '\0';
+      send(client, buffer);
+    }
+  }
+
+  void send(AsyncWebSocketClient* client, AsyncWebSocketMessageBuffer* buffer) {
+    if (client) {
+      client->text(buffer);
+    } else {
+      _queues.broadcast(buffer);
     }
   }
 };
@@ -194,17 +420,19 @@ class WebSocketRx : virtual public WebSocketConnector<T> {
                          void* arg,
                          uint8_t* data,
                          size_t len) {
-    if (type == WS_EVT_DATA) {
+    // resync messages are answered by the transmitter and must not reach the updater
+    if (type == WS_EVT_DATA && !WebSocketConnector<T>::isResync(arg, data, len)) {
       AwsFrameInfo* info = (AwsFrameInfo*)arg;
       if (info->final && info->index == 0 && info->len == len) {
-        if (info->opcode == WS_TEXT) {
-          DynamicJsonDocument jsonDocument = DynamicJsonDocument(WebSocketConnector<T>::_bufferSize);
+        if (info->opcode == WS_TEXT && WebSocketConnector<T>::admit(client)) {
+          PooledJsonDocument jsonDocument(WebSocketConnector<T>::_bufferSize);
           DeserializationError error = deserializeJson(jsonDocument, (char*)data);
           if (!error && jsonDocument.is<JsonObject>()) {
             JsonObject jsonObject = jsonDocument.as<JsonObject>();
             WebSocketConnector<T>::_statefulService->update(
                 jsonObject, _stateUpdater, WebSocketConnector<T>::clientId(client));
           }
+          WebSocketConnector<T>::release();
         }
       }
     }
@@ -265,8 +493,9 @@ class WebSocketTxRx : public WebSocketTx<T>, public WebSocketRx<T> {
                  void* arg,
                  uint8_t* data,
                  size_t len) {
-    WebSocketRx<T>::onWSEvent(server, client, type, arg, data, len);
+    // the transmitter goes first, the receiver parses frames in place
     WebSocketTx<T>::onWSEvent(server, client, type, arg, data, len);
+    WebSocketRx<T>::onWSEvent(server, client, type, arg, data, len);
   }
 };
 
@@ -3,12 +3,18 @@
 WiFiScanner::WiFiScanner(AsyncWebServer* server, SecurityManager* securityManager) {
   server->on(SCAN_NETWORKS_SERVICE_PATH,
              HTTP_GET,
-             securityManager->wrapRequest(std::bind(&WiFiScanner::scanNetworks, this, std::placeholders::_1),
-                                          AuthenticationPredicates::IS_ADMIN));
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&WiFiScanner::scanNetworks, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_ADMIN),
+                 RequestPriority::BACKGROUND,
+                 MAX_WIFI_SCANNER_SIZE));
   server->on(LIST_NETWORKS_SERVICE_PATH,
              HTTP_GET,
-             securityManager->wrapRequest(std::bind(&WiFiScanner::listNetworks, this, std::placeholders::_1),
-                                          AuthenticationPredicates::IS_ADMIN));
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&WiFiScanner::listNetworks, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_ADMIN),
+                 RequestPriority::BACKGROUND,
+                 MAX_WIFI_SCANNER_SIZE));
 };
 
 void WiFiScanner::scanNetworks(AsyncWebServerRequest* request) {
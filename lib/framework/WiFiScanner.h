@@ -9,6 +9,7 @@
 #include <ESPAsyncTCP.h>
 #endif
 
+#include <AdmissionControl.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
@@ -27,7 +27,12 @@ WiFiSettingsService::WiFiSettingsService(AsyncWebServer* server, FS* fs, Securit
       std::bind(&WiFiSettingsService::onStationModeDisconnected, this, std::placeholders::_1));
 #endif
 
-  addUpdateHandler([&](const String& originId) { reconfigureWiFiConnection(); }, false);
+  addUpdateHandler(
+      [](void* context, const String& originId, state_field_mask_t changedFields) {
+        static_cast<WiFiSettingsService*>(context)->reconfigureWiFiConnection();
+      },
+      this,
+      false);
 }
 
 void WiFiSettingsService::begin() {
@@ -3,8 +3,11 @@
 WiFiStatus::WiFiStatus(AsyncWebServer* server, SecurityManager* securityManager) {
   server->on(WIFI_STATUS_SERVICE_PATH,
              HTTP_GET,
-             securityManager->wrapRequest(std::bind(&WiFiStatus::wifiStatus, this, std::placeholders::_1),
-                                          AuthenticationPredicates::IS_AUTHENTICATED));
+             AdmissionControl::wrapRequest(
+                 securityManager->wrapRequest(std::bind(&WiFiStatus::wifiStatus, this, std::placeholders::_1),
+                                              AuthenticationPredicates::IS_AUTHENTICATED),
+                 RequestPriority::BACKGROUND,
+                 MAX_WIFI_STATUS_SIZE));
 #ifdef ESP32
   WiFi.onEvent(onStationModeConnected, WiFiEvent_t::SYSTEM_EVENT_STA_CONNECTED);
   WiFi.onEvent(onStationModeDisconnected, WiFiEvent_t::SYSTEM_EVENT_STA_DISCONNECTED);
@@ -18,6 +21,7 @@ WiFiStatus::WiFiStatus(AsyncWebServer* server, SecurityManager* securityManager)
 
 #ifdef ESP32
 void WiFiStatus::onStationModeConnected(WiFiEvent_t event, WiFiEventInfo_t info) {
+  BootProfile::mark("wifi_connected");
   Serial.println(F("WiFi Connected."));
 }
 
@@ -27,11 +31,13 @@ void WiFiStatus::onStationModeDisconnected(WiFiEvent_t event, WiFiEventInfo_t in
 }
 
 void WiFiStatus::onStationModeGotIP(WiFiEvent_t event, WiFiEventInfo_t info) {
+  BootProfile::mark("wifi_got_ip");
   Serial.printf_P(
       PSTR("WiFi Got IP. localIP=%s, hostName=%s\r\n"), WiFi.localIP().toString().c_str(), WiFi.getHostname());
 }
 #elif defined(ESP8266)
 void WiFiStatus::onStationModeConnected(const WiFiEventStationModeConnected& event) {
+  BootProfile::mark("wifi_connected");
   Serial.print(F("WiFi Connected. SSID="));
   Serial.println(event.ssid);
 }
@@ -42,6 +48,7 @@ void WiFiStatus::onStationModeDisconnected(const WiFiEventStationModeDisconnecte
 }
 
 void WiFiStatus::onStationModeGotIP(const WiFiEventStationModeGotIP& event) {
+  BootProfile::mark("wifi_got_ip");
   Serial.printf_P(
       PSTR("WiFi Got IP. localIP=%s, hostName=%s\r\n"), event.ip.toString().c_str(), WiFi.hostname().c_str());
 }
@@ -50,6 +57,12 @@ void WiFiStatus::onStationModeGotIP(const WiFiEventStationModeGotIP& event) {
 void WiFiStatus::wifiStatus(AsyncWebServerRequest* request) {
   AsyncJsonResponse* response = new AsyncJsonResponse(false, MAX_WIFI_STATUS_SIZE);
   JsonObject root = response->getRoot();
+  read(this, root);
+  response->setLength();
+  request->send(response);
+}
+
+void WiFiStatus::read(void* context, JsonObject& root) {
   wl_status_t status = WiFi.status();
   root["status"] = (uint8_t)status;
   if (status == WL_CONNECTED) {
@@ -70,6 +83,4 @@ void WiFiStatus::wifiStatus(AsyncWebServerRequest* request) {
       root["dns_ip_2"] = dnsIP2.toString();
     }
   }
-  response->setLength();
-  request->send(response);
 }
@@ -9,8 +9,10 @@
 #include <ESPAsyncTCP.h>
 #endif
 
+#include <AdmissionControl.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
+#include <BootProfile.h>
 #include <ESPAsyncWebServer.h>
 #include <IPAddress.h>
 #include <SecurityManager.h>
@@ -22,6 +24,9 @@ class WiFiStatus {
  public:
   WiFiStatus(AsyncWebServer* server, SecurityManager* securityManager);
 
+  // writes the status to root, also used to serve the status from the batch endpoint
+  static void read(void* context, JsonObject& root);
+
  private:
 #ifdef ESP32
   // static functions for logging WiFi events to the UART
@@ -0,0 +1,72 @@
+#include <WriteBehind.h>
+
+WriteBehind* WriteBehind::_first = nullptr;
+
+WriteBehind::WriteBehind(WriteFunction writeFunction, void* context) :
+    _writeFunction(writeFunction),
+    _context(context),
+    _next(_first),
+    _loopHook(writeIfDue, this),
+    _quietPeriod(0),
+    _maxDelay(0),
+    _scheduledAt(0),
+    _changedAt(0),
+    _pending(false) {
+  _first = this;
+}
+
+WriteBehind::~WriteBehind() {
+  for (WriteBehind** writeBehind = &_first; *writeBehind; writeBehind = &(*writeBehind)->_next) {
+    if (*writeBehind == this) {
+      *writeBehind = _next;
+      break;
+    }
+  }
+}
+
+void WriteBehind::enable(uint32_t quietPeriod, uint32_t maxDelay) {
+  _quietPeriod = quietPeriod;
+  _maxDelay = maxDelay;
+  _loopHook.attach();
+}
+
+void WriteBehind::disable() {
+  _loopHook.detach();
+  flush();
+}
+
+void WriteBehind::schedule() {
+  uint32_t now = millis();
+  if (!_pending) {
+    _scheduledAt = now;
+  }
+  _changedAt = now;
+  _pending = true;
+}
+
+void WriteBehind::flush() {
+  if (!_pending) {
+    return;
+  }
+  // cleared before writing, so a change made while the write is in progress schedules another
+  _pending = false;
+  _writeFunction(_context);
+}
+
+void WriteBehind::flushAll() {
+  for (WriteBehind* writeBehind = _first; writeBehind; writeBehind = writeBehind->_next) {
+    writeBehind->flush();
+  }
+}
+
+void WriteBehind::writeIfDue(void* context) {
+  WriteBehind* writeBehind = static_cast<WriteBehind*>(context);
+  if (!writeBehind->_pending) {
+    return;
+  }
+  uint32_t now = millis();
+  if (now - writeBehind->_changedAt >= writeBehind->_quietPeriod ||
+      now - writeBehind->_scheduledAt >= writeBehind->_maxDelay) {
+    writeBehind->flush();
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef WriteBehind_h
+#define WriteBehind_h
+
+#include <Arduino.h>
+#include <LoopHook.h>
+
+/**
+ * Defers a write, such as FSPersistence saving its state, to ESP8266React::loop() so a burst of changes results in a
+ * single write. Once scheduled, the write happens when no further changes have been scheduled for the quiet period, or
+ * when the maximum delay since the first unwritten change has passed, whichever is sooner.
+ *
+ * Every instance is kept in a list so pending writes can be flushed with flushAll() before the device restarts or its
+ * firmware is replaced.
+ */
+class WriteBehind {
+ public:
+  typedef void (*WriteFunction)(void* context);
+
+  WriteBehind(WriteFunction writeFunction, void* context);
+  ~WriteBehind();
+
+  void enable(uint32_t quietPeriod, uint32_t maxDelay);
+  void disable();
+
+  bool isEnabled() const {
+    return _loopHook.isAttached();
+  }
+
+  void schedule();
+  void flush();
+
+  static void flushAll();
+
+ private:
+  static WriteBehind* _first;
+
+  WriteFunction _writeFunction;
+  void* _context;
+  WriteBehind* _next;
+  LoopHook _loopHook;
+  uint32_t _quietPeriod;
+  uint32_t _maxDelay;
+  uint32_t _scheduledAt;
+  uint32_t _changedAt;
+  volatile bool _pending;
+
+  static void writeIfDue(void* context);
+};
+
+#endif  // end WriteBehind_h
@@ -0,0 +1,70 @@
+#include <AllocationCounter.h>
+
+#include <stdlib.h>
+
+#include <new>
+
+static size_t allocationCount = 0;
+static size_t allocatedBytes = 0;
+
+extern "C" {
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  allocationCount++;
+  allocatedBytes += size;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  allocationCount++;
+  allocatedBytes += count * size;
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  allocationCount++;
+  allocatedBytes += size;
+  return __real_realloc(ptr, size);
+}
+}
+
+void* operator new(size_t size) {
+  void* ptr = malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+AllocationCounter::AllocationCounter(benchmark::State& state) :
+    _state(state), _allocations(allocationCount), _bytes(allocatedBytes) {
+}
+
+AllocationCounter::~AllocationCounter() {
+  _state.counters["allocs"] = benchmark::Counter(allocationCount - _allocations, benchmark::Counter::kAvgIterations);
+  _state.counters["bytes"] = benchmark::Counter(allocatedBytes - _bytes, benchmark::Counter::kAvgIterations);
+}
+
+size_t AllocationCounter::allocations() {
+  return allocationCount;
+}
+
+size_t AllocationCounter::bytes() {
+  return allocatedBytes;
+}
@@ -0,0 +1,30 @@
+#ifndef AllocationCounter_h
+#define AllocationCounter_h
+
+#include <benchmark/benchmark.h>
+
+#include <stddef.h>
+
+/**
+ * Counts the heap allocations made while a benchmark runs and reports them per iteration as the "allocs" and "bytes"
+ * counters.
+ *
+ * malloc, calloc and realloc are intercepted with the linker's --wrap option (see env:native_bench) and the global
+ * operator new is routed through malloc, so allocations made by ArduinoJson and by the standard library are counted
+ * alike. Construct the counter after any setup and before the benchmark loop.
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter(benchmark::State& state);
+  ~AllocationCounter();
+
+  static size_t allocations();
+  static size_t bytes();
+
+ private:
+  benchmark::State& _state;
+  size_t _allocations;
+  size_t _bytes;
+};
+
+#endif  // end AllocationCounter_h
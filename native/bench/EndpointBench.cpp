@@ -0,0 +1,162 @@
+#include <AllocationCounter.h>
+#include <ESPFS.h>
+#include <LightMqttSettingsService.h>
+#include <LightStateService.h>
+
+/**
+ * Benchmarks for the JSON glue between a StatefulService and the outside world: the REST endpoint, WebSocket and MQTT
+ * transmission and filesystem persistence. Unsecured variants of the endpoints are used so authentication does not
+ * dominate the measurements.
+ */
+
+#define BENCH_ENDPOINT_PATH "/rest/bench"
+#define BENCH_SOCKET_PATH "/ws/bench"
+#define BENCH_SETTINGS_FILE "/config/bench.json"
+#define BENCH_ORIGIN_ID "bench"
+
+static void BM_HttpEndpoint_Get(benchmark::State& state) {
+  AsyncWebServer server(80);
+  StatefulService<LightState> service;
+  HttpEndpoint<LightState> endpoint(LightState::read, LightState::update, &service, &server, BENCH_ENDPOINT_PATH);
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    AsyncWebServerRequest request(HTTP_GET, BENCH_ENDPOINT_PATH);
+    server.handleRequest(&request);
+    benchmark::DoNotOptimize(request.response()->content());
+  }
+}
+BENCHMARK(BM_HttpEndpoint_Get);
+
+static void BM_HttpEndpoint_GetNotModified(benchmark::State& state) {
+  AsyncWebServer server(80);
+  StatefulService<LightState> service;
+  HttpEndpoint<LightState> endpoint(LightState::read, LightState::update, &service, &server, BENCH_ENDPOINT_PATH);
+  String etag = "\"" + String(service.getRevision(), HEX) + "\"";
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    AsyncWebServerRequest request(HTTP_GET, BENCH_ENDPOINT_PATH);
+    request.addHeader("If-None-Match", etag);
+    server.handleRequest(&request);
+    benchmark::DoNotOptimize(request.response()->code());
+  }
+}
+BENCHMARK(BM_HttpEndpoint_GetNotModified);
+
+// a state near the size of the buffer, sent with an AsyncJsonResponse when the buffer is over the stream threshold
+static void BM_HttpEndpoint_GetLarge(benchmark::State& state) {
+  AsyncWebServer server(80);
+  StatefulService<LightMqttSettings> service;
+  size_t bufferSize = state.range(0) ? 2 * HTTP_ENDPOINT_STREAM_THRESHOLD : HTTP_ENDPOINT_STREAM_THRESHOLD;
+  HttpGetEndpoint<LightMqttSettings> endpoint(
+      LightMqttSettingsFields::read, &service, &server, BENCH_ENDPOINT_PATH, bufferSize);
+  service.update(
+      [&](LightMqttSettings& settings) {
+        while (settings.name.length() < HTTP_ENDPOINT_STREAM_THRESHOLD * 3 / 4) {
+          settings.name += 'x';
+        }
+        return StateUpdateResult::CHANGED;
+      },
+      BENCH_ORIGIN_ID);
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    AsyncWebServerRequest request(HTTP_GET, BENCH_ENDPOINT_PATH);
+    server.handleRequest(&request);
+    benchmark::DoNotOptimize(request.response()->content());
+  }
+}
+BENCHMARK(BM_HttpEndpoint_GetLarge)->ArgName("large")->Arg(0)->Arg(1);
+
+static void BM_HttpEndpoint_Post(benchmark::State& state) {
+  AsyncWebServer server(80);
+  StatefulService<LightState> service;
+  HttpEndpoint<LightState> endpoint(LightState::read, LightState::update, &service, &server, BENCH_ENDPOINT_PATH);
+  String payloads[] = {"{\"led_on\":true}", "{\"led_on\":false}"};
+  size_t i = 0;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    AsyncWebServerRequest request(HTTP_POST, BENCH_ENDPOINT_PATH, payloads[i++ % 2]);
+    server.handleRequest(&request);
+    benchmark::DoNotOptimize(request.response()->content());
+  }
+}
+BENCHMARK(BM_HttpEndpoint_Post);
+
+static void BM_WebSocketTx_TransmitData(benchmark::State& state) {
+  AsyncWebServer server(80);
+  StatefulService<LightState> service;
+  WebSocketTx<LightState> webSocket(LightState::read, &service, &server, BENCH_SOCKET_PATH);
+  AsyncWebSocket* socket = server.socket(BENCH_SOCKET_PATH);
+  for (int64_t i = 0; i < state.range(0); i++) {
+    socket->connect(nullptr);
+  }
+  String originId = BENCH_ORIGIN_ID;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    service.callUpdateHandlers(originId);
+    for (AsyncWebSocketClient* client : socket->getClients()) {
+      client->clearMessages();
+    }
+  }
+}
+BENCHMARK(BM_WebSocketTx_TransmitData)->Arg(1)->Arg(4);
+
+static void BM_MqttPub_Publish(benchmark::State& state) {
+  AsyncMqttClient mqttClient;
+  StatefulService<LightState> service;
+  MqttPub<LightState> mqttPub(LightState::haRead, &service, &mqttClient, "homeassistant/light/bench/state");
+  mqttClient.setRecordPublications(false);
+  mqttClient.connect();
+  String originId = BENCH_ORIGIN_ID;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    service.callUpdateHandlers(originId);
+  }
+}
+BENCHMARK(BM_MqttPub_Publish);
+
+static void BM_FSPersistence_WriteToFS(benchmark::State& state) {
+  StatefulService<LightMqttSettings> service;
+  FSPersistence<LightMqttSettings> fsPersistence(LightMqttSettingsFields::read,
+                                                 LightMqttSettingsFields::update,
+                                                 &service,
+                                                 &ESPFS,
+                                                 BENCH_SETTINGS_FILE,
+                                                 LightMqttSettingsFields::capacity());
+  fsPersistence.readFromFS();
+  bool changed = state.range(0);
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    if (changed) {
+      service.updateWithoutPropagation([](LightMqttSettings& settings) {
+        settings.name = settings.name == "a" ? "b" : "a";
+        return StateUpdateResult::CHANGED;
+      });
+    }
+    benchmark::DoNotOptimize(fsPersistence.writeToFS());
+    // amortizes compaction of the config store
+    LoopHook::loopAll();
+  }
+#if FS_PERSISTENCE_CONFIG_STORE
+  state.counters["log_bytes"] = ConfigStore::forFS(&ESPFS)->size();
+#else
+  state.counters["file_bytes"] = ESPFS.open(BENCH_SETTINGS_FILE, "r").size();
+#endif
+}
+// unchanged state is skipped
+BENCHMARK(BM_FSPersistence_WriteToFS)->ArgName("changed")->Arg(0)->Arg(1);
+
+static void BM_FSPersistence_ReadFromFS(benchmark::State& state) {
+  StatefulService<LightMqttSettings> service;
+  FSPersistence<LightMqttSettings> fsPersistence(LightMqttSettingsFields::read,
+                                                 LightMqttSettingsFields::update,
+                                                 &service,
+                                                 &ESPFS,
+                                                 BENCH_SETTINGS_FILE,
+                                                 LightMqttSettingsFields::capacity());
+  fsPersistence.writeToFS();
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    fsPersistence.readFromFS();
+  }
+}
+BENCHMARK(BM_FSPersistence_ReadFromFS);
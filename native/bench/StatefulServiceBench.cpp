@@ -0,0 +1,123 @@
+#include <AllocationCounter.h>
+#include <LightStateService.h>
+
+/**
+ * Benchmarks for the StatefulService hot path: updates and reads through both the std::function and the JSON glue,
+ * and the fan-out of update handlers.
+ *
+ * LightState is served from a snapshot, the benchmarks which depend on the read path are repeated for LockedLightState
+ * which is read under the access mutex.
+ */
+
+class LockedLightState {
+ public:
+  bool ledOn;
+
+  static void read(LockedLightState& settings, JsonObject& root) {
+    root["led_on"] = settings.ledOn;
+  }
+
+  static StateUpdateResult update(JsonObject& root, LockedLightState& lightState) {
+    boolean newState = root["led_on"] | DEFAULT_LED_STATE;
+    if (lightState.ledOn != newState) {
+      lightState.ledOn = newState;
+      return StateUpdateResult::CHANGED;
+    }
+    return StateUpdateResult::UNCHANGED;
+  }
+};
+
+// room for the largest fan-out benchmarked
+template <>
+struct StateTraits<LockedLightState> : DefaultStateTraits {
+  static const uint8_t updateHandlerCapacity = 16;
+};
+
+template <class T>
+static StateUpdateResult toggle(T& state) {
+  state.ledOn = !state.ledOn;
+  return StateUpdateResult::CHANGED;
+}
+
+template <class T>
+static void BM_StatefulService_Update(benchmark::State& state) {
+  StatefulService<T> service;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(service.update(toggle<T>, "bench"));
+  }
+}
+BENCHMARK_TEMPLATE(BM_StatefulService_Update, LightState);
+BENCHMARK_TEMPLATE(BM_StatefulService_Update, LockedLightState);
+
+template <class T>
+static void BM_StatefulService_UpdateWithoutPropagation(benchmark::State& state) {
+  StatefulService<T> service;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(service.updateWithoutPropagation(toggle<T>));
+  }
+}
+BENCHMARK_TEMPLATE(BM_StatefulService_UpdateWithoutPropagation, LightState);
+BENCHMARK_TEMPLATE(BM_StatefulService_UpdateWithoutPropagation, LockedLightState);
+
+template <class T>
+static void BM_StatefulService_Read(benchmark::State& state) {
+  StatefulService<T> service;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    bool ledOn;
+    service.read([&](T& lightState) { ledOn = lightState.ledOn; });
+    benchmark::DoNotOptimize(ledOn);
+  }
+}
+BENCHMARK_TEMPLATE(BM_StatefulService_Read, LightState);
+BENCHMARK_TEMPLATE(BM_StatefulService_Read, LockedLightState);
+
+template <class T>
+static void BM_StatefulService_JsonUpdate(benchmark::State& state) {
+  StatefulService<T> service;
+  AllocationCounter counter(state);
+  bool ledOn = false;
+  for (auto _ : state) {
+    DynamicJsonDocument jsonDocument(DEFAULT_BUFFER_SIZE);
+    JsonObject jsonObject = jsonDocument.to<JsonObject>();
+    jsonObject["led_on"] = ledOn = !ledOn;
+    benchmark::DoNotOptimize(service.update(jsonObject, T::update, "bench"));
+  }
+}
+BENCHMARK_TEMPLATE(BM_StatefulService_JsonUpdate, LightState);
+BENCHMARK_TEMPLATE(BM_StatefulService_JsonUpdate, LockedLightState);
+
+template <class T>
+static void BM_StatefulService_JsonRead(benchmark::State& state) {
+  StatefulService<T> service;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    DynamicJsonDocument jsonDocument(DEFAULT_BUFFER_SIZE);
+    JsonObject jsonObject = jsonDocument.to<JsonObject>();
+    service.read(jsonObject, T::read);
+    benchmark::DoNotOptimize(jsonObject);
+  }
+}
+BENCHMARK_TEMPLATE(BM_StatefulService_JsonRead, LightState);
+BENCHMARK_TEMPLATE(BM_StatefulService_JsonRead, LockedLightState);
+
+static void BM_StatefulService_CallUpdateHandlers(benchmark::State& state) {
+  StatefulService<LockedLightState> service;
+  size_t calls = 0;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    service.addUpdateHandler(
+        [](void* context, const String& originId, state_field_mask_t changedFields) {
+          (*static_cast<size_t*>(context))++;
+        },
+        &calls);
+  }
+  String originId = "bench";
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    service.callUpdateHandlers(originId);
+  }
+  benchmark::DoNotOptimize(calls);
+}
+BENCHMARK(BM_StatefulService_CallUpdateHandlers)->Arg(1)->Arg(4)->Arg(16);
@@ -0,0 +1,133 @@
+#include <Arduino.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                              startTime)
+      .count();
+}
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                              startTime)
+      .count();
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+static uint8_t pinStates[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < sizeof(pinStates)) {
+    pinStates[pin] = value;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < sizeof(pinStates) ? pinStates[pin] : LOW;
+}
+
+long random(long howbig) {
+  if (howbig <= 0) {
+    return 0;
+  }
+  return rand() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) {
+    return howsmall;
+  }
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  return write((const uint8_t*)buffer, std::min((size_t)len, sizeof(buffer) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+uint32_t EspClass::getChipId() {
+  return 0x00c0ffee;
+}
+
+uint32_t EspClass::getFreeHeap() {
+  return _freeHeap;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize() {
+  return _maxFreeBlockSize;
+}
+
+uint8_t EspClass::getHeapFragmentation() {
+  return 0;
+}
+
+uint8_t EspClass::getCpuFreqMHz() {
+  return 160;
+}
+
+uint32_t EspClass::getSketchSize() {
+  return 0;
+}
+
+uint32_t EspClass::getFreeSketchSpace() {
+  return 0;
+}
+
+const char* EspClass::getSdkVersion() {
+  return "native";
+}
+
+uint32_t EspClass::getFlashChipSize() {
+  return 4 * 1024 * 1024;
+}
+
+uint32_t EspClass::getFlashChipSpeed() {
+  return 40000000;
+}
+
+uint32_t EspClass::random() {
+  return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+void EspClass::restart() {
+  _restartCount++;
+}
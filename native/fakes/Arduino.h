@@ -0,0 +1,105 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+/**
+ * Minimal Arduino core for building the framework on the host (see the "native" environment in platformio.ini).
+ *
+ * The host build defines ESP8266 so the framework takes its ESP8266 code paths, this header supplies just enough of
+ * the ESP8266 Arduino core for those paths to compile and run in-process.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <algorithm>
+#include <functional>
+
+#include <WString.h>
+#include <Print.h>
+#include <Stream.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+#define F(string_literal) (string_literal)
+#define PSTR(string_literal) (string_literal)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long baud) {
+  }
+  int available() {
+    return 0;
+  }
+  int read() {
+    return -1;
+  }
+  int peek() {
+    return -1;
+  }
+  size_t write(uint8_t c);
+  size_t write(const uint8_t* buffer, size_t size);
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+ public:
+  uint32_t getChipId();
+  uint32_t getFreeHeap();
+  uint32_t getMaxFreeBlockSize();
+  uint8_t getHeapFragmentation();
+  uint8_t getCpuFreqMHz();
+  uint32_t getSketchSize();
+  uint32_t getFreeSketchSpace();
+  const char* getSdkVersion();
+  uint32_t getFlashChipSize();
+  uint32_t getFlashChipSpeed();
+  uint32_t random();
+  void restart();
+
+  // Host only: the number of times restart() has been called
+  uint32_t restartCount() {
+    return _restartCount;
+  }
+
+  // Host only: set what getFreeHeap() and getMaxFreeBlockSize() report, simulating a low heap
+  void setHeap(uint32_t freeHeap, uint32_t maxFreeBlockSize) {
+    _freeHeap = freeHeap;
+    _maxFreeBlockSize = maxFreeBlockSize;
+  }
+
+ private:
+  uint32_t _restartCount = 0;
+  uint32_t _freeHeap = 40 * 1024;
+  uint32_t _maxFreeBlockSize = 32 * 1024;
+};
+
+extern EspClass ESP;
+
+#endif  // end Arduino_h
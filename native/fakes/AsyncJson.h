@@ -0,0 +1,93 @@
+#ifndef AsyncJson_h
+#define AsyncJson_h
+
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+#define DYNAMIC_JSON_DOCUMENT_SIZE 1024
+#define JSON_MIMETYPE "application/json"
+
+class AsyncJsonResponse : public AsyncWebServerResponse {
+ public:
+  AsyncJsonResponse(bool isArray = false, size_t maxJsonBufferSize = DYNAMIC_JSON_DOCUMENT_SIZE) :
+      AsyncWebServerResponse(200, JSON_MIMETYPE), _jsonBuffer(maxJsonBufferSize) {
+    if (isArray) {
+      _root = _jsonBuffer.createNestedArray();
+    } else {
+      _root = _jsonBuffer.createNestedObject();
+    }
+  }
+
+  JsonVariant& getRoot() {
+    return _root;
+  }
+
+  size_t setLength() {
+    _contentLength = measureJson(_root);
+    return _contentLength;
+  }
+
+  String content() {
+    String content;
+    serializeJson(_root, content);
+    return content;
+  }
+
+ private:
+  DynamicJsonDocument _jsonBuffer;
+  JsonVariant _root;
+};
+
+typedef std::function<void(AsyncWebServerRequest* request, JsonVariant& json)> ArJsonRequestHandlerFunction;
+
+class AsyncCallbackJsonWebHandler : public AsyncWebHandler {
+ public:
+  AsyncCallbackJsonWebHandler(const String& uri,
+                              ArJsonRequestHandlerFunction onRequest,
+                              size_t maxJsonBufferSize = DYNAMIC_JSON_DOCUMENT_SIZE) :
+      _uri(uri),
+      _method(HTTP_POST | HTTP_PUT | HTTP_PATCH),
+      _onRequest(onRequest),
+      _maxContentLength(16384),
+      _maxJsonBufferSize(maxJsonBufferSize) {
+  }
+
+  void setMethod(WebRequestMethodComposite method) {
+    _method = method;
+  }
+  void setMaxContentLength(int maxContentLength) {
+    _maxContentLength = maxContentLength;
+  }
+  void onRequest(ArJsonRequestHandlerFunction fn) {
+    _onRequest = fn;
+  }
+
+  bool canHandle(AsyncWebServerRequest* request) {
+    return _onRequest && (_method & request->method()) && uriMatches(_uri, request) &&
+           request->contentType().equalsIgnoreCase(JSON_MIMETYPE);
+  }
+
+  void handleRequest(AsyncWebServerRequest* request) {
+    if (request->contentLength() > _maxContentLength) {
+      request->send(413);
+      return;
+    }
+    DynamicJsonDocument jsonBuffer(_maxJsonBufferSize);
+    DeserializationError error = deserializeJson(jsonBuffer, request->body().c_str());
+    if (!error) {
+      JsonVariant json = jsonBuffer.as<JsonVariant>();
+      _onRequest(request, json);
+      return;
+    }
+    request->send(500);
+  }
+
+ private:
+  String _uri;
+  WebRequestMethodComposite _method;
+  ArJsonRequestHandlerFunction _onRequest;
+  size_t _maxContentLength;
+  size_t _maxJsonBufferSize;
+};
+
+#endif  // end AsyncJson_h
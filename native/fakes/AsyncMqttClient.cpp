@@ -0,0 +1,72 @@
+#include <AsyncMqttClient.h>
+
+#include <algorithm>
+
+void AsyncMqttClient::connect() {
+  if (_connected) {
+    return;
+  }
+  _connected = true;
+  for (auto& callback : _onConnectUserCallbacks) {
+    callback(false);
+  }
+}
+
+void AsyncMqttClient::disconnect(bool force) {
+  if (!_connected) {
+    return;
+  }
+  _connected = false;
+  _subscriptions.clear();
+  for (auto& callback : _onDisconnectUserCallbacks) {
+    callback(AsyncMqttClientDisconnectReason::TCP_DISCONNECTED);
+  }
+}
+
+uint16_t AsyncMqttClient::subscribe(const char* topic, uint8_t qos) {
+  if (!_connected) {
+    return 0;
+  }
+  _subscriptions.push_back(topic);
+  return _nextPacketId++;
+}
+
+uint16_t AsyncMqttClient::unsubscribe(const char* topic) {
+  if (!_connected) {
+    return 0;
+  }
+  _subscriptions.erase(std::remove(_subscriptions.begin(), _subscriptions.end(), String(topic)),
+                       _subscriptions.end());
+  return _nextPacketId++;
+}
+
+uint16_t AsyncMqttClient::publish(const char* topic,
+                                  uint8_t qos,
+                                  bool retain,
+                                  const char* payload,
+                                  size_t length,
+                                  bool dup,
+                                  uint16_t message_id) {
+  if (!_connected) {
+    return 0;
+  }
+  if (!_recordPublications) {
+    return qos == 0 ? 1 : _nextPacketId++;
+  }
+  Publication publication;
+  publication.topic = topic;
+  publication.payload = payload ? (length ? String(payload, length) : String(payload)) : String();
+  publication.qos = qos;
+  publication.retain = retain;
+  _publications.push_back(publication);
+  return qos == 0 ? 1 : _nextPacketId++;
+}
+
+void AsyncMqttClient::receive(const String& topic, const String& payload) {
+  std::vector<char> topicBuffer(topic.c_str(), topic.c_str() + topic.length() + 1);
+  std::vector<char> payloadBuffer(payload.c_str(), payload.c_str() + payload.length());
+  AsyncMqttClientMessageProperties properties = {0, false, false};
+  for (auto& callback : _onMessageUserCallbacks) {
+    callback(topicBuffer.data(), payloadBuffer.data(), properties, payload.length(), 0, payload.length());
+  }
+}
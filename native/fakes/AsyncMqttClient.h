@@ -0,0 +1,131 @@
+#ifndef AsyncMqttClient_h
+#define AsyncMqttClient_h
+
+#include <Arduino.h>
+
+#include <functional>
+#include <vector>
+
+enum class AsyncMqttClientDisconnectReason : int8_t {
+  TCP_DISCONNECTED = 0,
+  MQTT_UNACCEPTABLE_PROTOCOL_VERSION = 1,
+  MQTT_IDENTIFIER_REJECTED = 2,
+  MQTT_SERVER_UNAVAILABLE = 3,
+  MQTT_MALFORMED_CREDENTIALS = 4,
+  MQTT_NOT_AUTHORIZED = 5,
+  ESP8266_NOT_ENOUGH_SPACE = 6,
+  TLS_BAD_FINGERPRINT = 7
+};
+
+struct AsyncMqttClientMessageProperties {
+  uint8_t qos;
+  bool dup;
+  bool retain;
+};
+
+namespace AsyncMqttClientInternals {
+typedef std::function<void(bool sessionPresent)> OnConnectUserCallback;
+typedef std::function<void(AsyncMqttClientDisconnectReason reason)> OnDisconnectUserCallback;
+typedef std::function<void(char* topic,
+                           char* payload,
+                           AsyncMqttClientMessageProperties properties,
+                           size_t len,
+                           size_t index,
+                           size_t total)>
+    OnMessageUserCallback;
+}  // namespace AsyncMqttClientInternals
+
+/**
+ * In-process stand-in for AsyncMqttClient. Nothing leaves the process: publishes are recorded so they can be
+ * inspected, and connection events and inbound messages are raised on demand by the host.
+ */
+class AsyncMqttClient {
+ public:
+  struct Publication {
+    String topic;
+    String payload;
+    uint8_t qos;
+    bool retain;
+  };
+
+  AsyncMqttClient& onConnect(AsyncMqttClientInternals::OnConnectUserCallback callback) {
+    _onConnectUserCallbacks.push_back(callback);
+    return *this;
+  }
+  AsyncMqttClient& onDisconnect(AsyncMqttClientInternals::OnDisconnectUserCallback callback) {
+    _onDisconnectUserCallbacks.push_back(callback);
+    return *this;
+  }
+  AsyncMqttClient& onMessage(AsyncMqttClientInternals::OnMessageUserCallback callback) {
+    _onMessageUserCallbacks.push_back(callback);
+    return *this;
+  }
+
+  AsyncMqttClient& setKeepAlive(uint16_t keepAlive) {
+    return *this;
+  }
+  AsyncMqttClient& setClientId(const char* clientId) {
+    _clientId = clientId;
+    return *this;
+  }
+  AsyncMqttClient& setCleanSession(bool cleanSession) {
+    return *this;
+  }
+  AsyncMqttClient& setMaxTopicLength(uint16_t maxTopicLength) {
+    return *this;
+  }
+  AsyncMqttClient& setCredentials(const char* username, const char* password = nullptr) {
+    return *this;
+  }
+  AsyncMqttClient& setServer(const char* host, uint16_t port) {
+    return *this;
+  }
+  const char* getClientId() {
+    return _clientId.c_str();
+  }
+
+  bool connected() const {
+    return _connected;
+  }
+  void connect();
+  void disconnect(bool force = false);
+
+  uint16_t subscribe(const char* topic, uint8_t qos);
+  uint16_t unsubscribe(const char* topic);
+  uint16_t publish(const char* topic,
+                   uint8_t qos,
+                   bool retain,
+                   const char* payload = nullptr,
+                   size_t length = 0,
+                   bool dup = false,
+                   uint16_t message_id = 0);
+
+  // Host only: deliver a message to the client as if it arrived from the broker
+  void receive(const String& topic, const String& payload);
+
+  // Host only: inspect and clear what has been published and subscribed
+  std::vector<Publication>& publications() {
+    return _publications;
+  }
+  std::vector<String>& subscriptions() {
+    return _subscriptions;
+  }
+
+  // Host only: stop recording publications, so the recording does not show up in measurements
+  void setRecordPublications(bool recordPublications) {
+    _recordPublications = recordPublications;
+  }
+
+ private:
+  bool _connected = false;
+  bool _recordPublications = true;
+  uint16_t _nextPacketId = 1;
+  String _clientId;
+  std::vector<AsyncMqttClientInternals::OnConnectUserCallback> _onConnectUserCallbacks;
+  std::vector<AsyncMqttClientInternals::OnDisconnectUserCallback> _onDisconnectUserCallbacks;
+  std::vector<AsyncMqttClientInternals::OnMessageUserCallback> _onMessageUserCallbacks;
+  std::vector<Publication> _publications;
+  std::vector<String> _subscriptions;
+};
+
+#endif  // end AsyncMqttClient_h
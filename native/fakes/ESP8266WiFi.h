@@ -0,0 +1,89 @@
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+#include <memory>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum WiFiMode { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } WiFiMode_t;
+
+struct WiFiEventStationModeConnected {
+  String ssid;
+  uint8_t channel;
+};
+
+struct WiFiEventStationModeDisconnected {
+  String ssid;
+  uint8_t reason;
+};
+
+struct WiFiEventStationModeGotIP {
+  IPAddress ip;
+  IPAddress mask;
+  IPAddress gw;
+};
+
+typedef std::shared_ptr<void> WiFiEventHandler;
+
+/**
+ * In-process stand-in for the ESP8266 WiFi object. The station is reported as connected with a fixed address so
+ * that code which checks the connection state behaves as it would on a healthy network.
+ */
+class ESP8266WiFiClass {
+ public:
+  wl_status_t status() {
+    return _connected ? WL_CONNECTED : WL_DISCONNECTED;
+  }
+  bool isConnected() {
+    return _connected;
+  }
+  bool disconnect(bool wifioff = false) {
+    _connected = false;
+    return true;
+  }
+  bool mode(WiFiMode_t mode) {
+    _mode = mode;
+    return true;
+  }
+  WiFiMode_t getMode() {
+    return _mode;
+  }
+  IPAddress localIP() {
+    return IPAddress(192, 168, 0, 2);
+  }
+  String macAddress() {
+    return "C0:FF:EE:C0:FF:EE";
+  }
+  String hostname() {
+    return "esp-react";
+  }
+
+  WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> handler) {
+    return WiFiEventHandler();
+  }
+  WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> handler) {
+    return WiFiEventHandler();
+  }
+  WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> handler) {
+    return WiFiEventHandler();
+  }
+
+ private:
+  bool _connected = true;
+  WiFiMode_t _mode = WIFI_STA;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif  // end ESP8266WiFi_h
@@ -0,0 +1,6 @@
+#ifndef ESPAsyncTCP_h
+#define ESPAsyncTCP_h
+
+// The host build has no TCP stack, ESPAsyncWebServer.h and AsyncMqttClient.h are faked in-process.
+
+#endif  // end ESPAsyncTCP_h
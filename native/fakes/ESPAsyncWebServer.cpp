@@ -0,0 +1,256 @@
+#include <ESPAsyncWebServer.h>
+
+static const String emptyString;
+
+const AsyncWebHeader* AsyncWebServerResponse::header(const String& name) const {
+  for (const AsyncWebHeader& header : _headers) {
+    if (header.name().equalsIgnoreCase(name)) {
+      return &header;
+    }
+  }
+  return nullptr;
+}
+
+String AsyncCallbackResponse::content() {
+  String content;
+  std::vector<uint8_t> buffer(_chunkSize);
+  size_t index = 0;
+  while (!_contentLength || index < _contentLength) {
+    size_t len = _callback(buffer.data(), _chunkSize, index);
+    if (len == 0) {
+      break;
+    }
+    _maxChunkLength = std::max(_maxChunkLength, len);
+    content.concat((const char*)buffer.data(), len);
+    index += len;
+  }
+  return content;
+}
+
+String AsyncAbstractResponse::content() {
+  String content;
+  if (!_started()) {
+    return content;
+  }
+  uint8_t buffer[64];
+  for (size_t len = _fillBuffer(buffer, sizeof(buffer)); len; len = _fillBuffer(buffer, sizeof(buffer))) {
+    content.concat((const char*)buffer, len);
+  }
+  return content;
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+  if (_disconnectHandler) {
+    _disconnectHandler();
+  }
+  for (AsyncWebHeader* header : _headers) {
+    delete header;
+  }
+  for (AsyncWebParameter* param : _params) {
+    delete param;
+  }
+  delete _response;
+}
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+  for (AsyncWebHeader* header : _headers) {
+    if (header->name().equalsIgnoreCase(name)) {
+      return header;
+    }
+  }
+  return nullptr;
+}
+
+const String& AsyncWebServerRequest::header(const char* name) const {
+  AsyncWebHeader* h = getHeader(name);
+  return h ? h->value() : emptyString;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+  for (AsyncWebParameter* param : _params) {
+    if (param->name() == name) {
+      return param;
+    }
+  }
+  return nullptr;
+}
+
+const String& AsyncWebServerRequest::arg(const String& name) const {
+  AsyncWebParameter* param = getParam(name);
+  return param ? param->value() : emptyString;
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+  // like the device, the first response wins and later ones are discarded
+  if (_response) {
+    delete response;
+    return;
+  }
+  _response = response;
+  _response->_respond(this);
+}
+
+AsyncWebServer::~AsyncWebServer() {
+  for (AsyncCallbackWebHandler* handler : _ownedHandlers) {
+    delete handler;
+  }
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri,
+                                            WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction onRequest) {
+  AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler();
+  handler->setUri(uri);
+  handler->setMethod(method);
+  handler->onRequest(onRequest);
+  _ownedHandlers.push_back(handler);
+  addHandler(handler);
+  return *handler;
+}
+
+void AsyncWebServer::handleRequest(AsyncWebServerRequest* request) {
+  for (AsyncWebHandler* handler : _handlers) {
+    if (handler->filter(request) && handler->canHandle(request)) {
+      if (request->contentLength()) {
+        handler->handleBody(request,
+                            (uint8_t*)request->body().c_str(),
+                            request->contentLength(),
+                            0,
+                            request->contentLength());
+      }
+      handler->handleRequest(request);
+      return;
+    }
+  }
+  if (_notFound) {
+    _notFound(request);
+  } else {
+    request->send(404);
+  }
+}
+
+AsyncWebSocket* AsyncWebServer::socket(const String& url) {
+  for (AsyncWebHandler* handler : _handlers) {
+    AsyncWebSocket* socket = dynamic_cast<AsyncWebSocket*>(handler);
+    if (socket && url == socket->url()) {
+      return socket;
+    }
+  }
+  return nullptr;
+}
+
+void AsyncWebSocketClient::text(const char* message, size_t len) {
+  if (_status != WS_CONNECTED) {
+    return;
+  }
+  if (queueIsFull()) {
+    _dropped++;
+    return;
+  }
+  _queue.push_back(String(message, len));
+}
+
+void AsyncWebSocketClient::text(AsyncWebSocketMessageBuffer* buffer) {
+  text((const char*)buffer->get(), buffer->length());
+  _server->cleanBuffers();
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char* message) {
+  _status = WS_DISCONNECTING;
+}
+
+std::vector<String> AsyncWebSocketClient::takeMessages() {
+  std::vector<String> messages(_queue.begin(), _queue.end());
+  _queue.clear();
+  return messages;
+}
+
+AsyncWebSocket::~AsyncWebSocket() {
+  for (AsyncWebSocketClient* client : _clients) {
+    delete client;
+  }
+  for (AsyncWebSocketMessageBuffer* buffer : _buffers) {
+    delete buffer;
+  }
+}
+
+size_t AsyncWebSocket::count() const {
+  size_t n = 0;
+  for (AsyncWebSocketClient* client : _clients) {
+    if (client->status() == WS_CONNECTED) {
+      n++;
+    }
+  }
+  return n;
+}
+
+AsyncWebSocketClient* AsyncWebSocket::client(uint32_t id) {
+  for (AsyncWebSocketClient* client : _clients) {
+    if (client->id() == id && client->status() == WS_CONNECTED) {
+      return client;
+    }
+  }
+  return nullptr;
+}
+
+void AsyncWebSocket::textAll(const char* message, size_t len) {
+  for (AsyncWebSocketClient* client : _clients) {
+    client->text(message, len);
+  }
+}
+
+void AsyncWebSocket::textAll(AsyncWebSocketMessageBuffer* buffer) {
+  buffer->lock();
+  for (AsyncWebSocketClient* client : _clients) {
+    client->text((const char*)buffer->get(), buffer->length());
+  }
+  buffer->unlock();
+  cleanBuffers();
+}
+
+AsyncWebSocketClient* AsyncWebSocket::connect(AsyncWebServerRequest* request) {
+  if (request && !filter(request)) {
+    return nullptr;
+  }
+  AsyncWebSocketClient* client = new AsyncWebSocketClient(this, _nextId++);
+  _clients.push_back(client);
+  if (_eventHandler) {
+    _eventHandler(this, client, WS_EVT_CONNECT, request, nullptr, 0);
+  }
+  return client;
+}
+
+void AsyncWebSocket::receive(AsyncWebSocketClient* client, const String& message) {
+  if (!_eventHandler) {
+    return;
+  }
+  // the device null terminates single frame text messages before raising the event
+  std::vector<uint8_t> data(message.c_str(), message.c_str() + message.length() + 1);
+  AwsFrameInfo info = {};
+  info.message_opcode = WS_TEXT;
+  info.opcode = WS_TEXT;
+  info.final = 1;
+  info.len = message.length();
+  info.index = 0;
+  _eventHandler(this, client, WS_EVT_DATA, &info, data.data(), message.length());
+}
+
+void AsyncWebSocket::disconnect(AsyncWebSocketClient* client) {
+  client->_status = WS_DISCONNECTED;
+  if (_eventHandler) {
+    _eventHandler(this, client, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+  }
+  _clients.remove(client);
+  delete client;
+}
+
+void AsyncWebSocket::cleanBuffers() {
+  for (auto i = _buffers.begin(); i != _buffers.end();) {
+    if ((*i)->canDelete()) {
+      delete *i;
+      i = _buffers.erase(i);
+    } else {
+      ++i;
+    }
+  }
+}
@@ -0,0 +1,588 @@
+#ifndef ESPAsyncWebServer_h
+#define ESPAsyncWebServer_h
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include <functional>
+#include <list>
+#include <vector>
+
+/**
+ * In-process stand-in for ESPAsyncWebServer.
+ *
+ * Handlers are registered exactly as they are on the device. Instead of a TCP stack, callers build an
+ * AsyncWebServerRequest and pass it to AsyncWebServer::handleRequest(), then inspect the response the handler sent.
+ * As on the device, the request's disconnect callbacks run when the request is destroyed.
+ *
+ * Responses are sent at once, apart from those derived from AsyncAbstractResponse which, like the device, are driven
+ * through _respond() and _ack(). AsyncWebServerRequest::poll() stands in for the connection's poll.
+ */
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000,
+  HTTP_HEAD = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+typedef std::function<void(void)> ArDisconnectHandler;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebSocket;
+class AsyncWebServerResponse;
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest* request)> ArRequestFilterFunction;
+typedef std::function<
+    void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data, size_t len, bool final)>
+    ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+typedef enum {
+  RESPONSE_SETUP,
+  RESPONSE_HEADERS,
+  RESPONSE_CONTENT,
+  RESPONSE_WAIT_ACK,
+  RESPONSE_END,
+  RESPONSE_FAILED
+} WebResponseState;
+
+class AsyncWebHeader {
+ public:
+  AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {
+  }
+  const String& name() const {
+    return _name;
+  }
+  const String& value() const {
+    return _value;
+  }
+
+ private:
+  String _name;
+  String _value;
+};
+
+class AsyncWebParameter {
+ public:
+  AsyncWebParameter(const String& name, const String& value) : _name(name), _value(value) {
+  }
+  const String& name() const {
+    return _name;
+  }
+  const String& value() const {
+    return _value;
+  }
+
+ private:
+  String _name;
+  String _value;
+};
+
+class AsyncWebServerResponse {
+ public:
+  AsyncWebServerResponse(int code = 200, const String& contentType = String()) :
+      _code(code), _contentType(contentType), _contentLength(0), _state(RESPONSE_SETUP) {
+  }
+  virtual ~AsyncWebServerResponse() {
+  }
+
+  virtual bool _started() const {
+    return _state > RESPONSE_SETUP;
+  }
+  virtual bool _finished() const {
+    return _state > RESPONSE_WAIT_ACK;
+  }
+  virtual bool _sourceValid() const {
+    return true;
+  }
+  virtual void _respond(AsyncWebServerRequest* request) {
+    _state = RESPONSE_END;
+  }
+  virtual size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) {
+    return 0;
+  }
+
+  void setCode(int code) {
+    _code = code;
+  }
+  void setContentLength(size_t len) {
+    _contentLength = len;
+  }
+  void setContentType(const String& type) {
+    _contentType = type;
+  }
+  void addHeader(const String& name, const String& value) {
+    _headers.push_back(AsyncWebHeader(name, value));
+  }
+
+  // Host only: accessors used to inspect what was sent
+  int code() const {
+    return _code;
+  }
+  const String& contentType() const {
+    return _contentType;
+  }
+  size_t contentLength() const {
+    return _contentLength;
+  }
+  const AsyncWebHeader* header(const String& name) const;
+  virtual String content() {
+    return String();
+  }
+
+ protected:
+  int _code;
+  String _contentType;
+  size_t _contentLength;
+  std::vector<AsyncWebHeader> _headers;
+  WebResponseState _state;
+};
+
+/**
+ * The device's base for responses which fill the send buffer as the connection drains. The content is read from
+ * _fillBuffer() when it is inspected, once the response has been started.
+ */
+class AsyncAbstractResponse : public AsyncWebServerResponse {
+ public:
+  void _respond(AsyncWebServerRequest* request) {
+    _state = RESPONSE_HEADERS;
+    _ack(request, 0, 0);
+  }
+  size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) {
+    _state = RESPONSE_END;
+    return 0;
+  }
+  virtual size_t _fillBuffer(uint8_t* buf, size_t maxLen) {
+    return 0;
+  }
+  String content();
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+ public:
+  AsyncBasicResponse(int code, const String& contentType = String(), const String& content = String()) :
+      AsyncWebServerResponse(code, contentType), _content(content) {
+    _contentLength = _content.length();
+  }
+  String content() {
+    return _content;
+  }
+
+ private:
+  String _content;
+};
+
+/**
+ * Drains the filler into a string when the content is inspected, honouring the filler contract of the device
+ * implementation (a zero length return ends the response).
+ */
+class AsyncCallbackResponse : public AsyncWebServerResponse {
+ public:
+  AsyncCallbackResponse(const String& contentType, size_t len, AwsResponseFiller callback, size_t chunkSize = 1460) :
+      AsyncWebServerResponse(200, contentType), _callback(callback), _chunkSize(chunkSize) {
+    _contentLength = len;
+  }
+  String content();
+
+  // Host only: the largest chunk the filler produced
+  size_t maxChunkLength() const {
+    return _maxChunkLength;
+  }
+
+ private:
+  AwsResponseFiller _callback;
+  size_t _chunkSize;
+  size_t _maxChunkLength = 0;
+};
+
+class AsyncWebServerRequest {
+ public:
+  AsyncWebServerRequest(WebRequestMethodComposite method, const String& url, const String& body = String()) :
+      _method(method), _url(url), _body(body), _contentType("application/json"), _response(nullptr) {
+  }
+  ~AsyncWebServerRequest();
+
+  WebRequestMethodComposite method() const {
+    return _method;
+  }
+  const String& url() const {
+    return _url;
+  }
+  const String& contentType() const {
+    return _contentType;
+  }
+  size_t contentLength() const {
+    return _body.length();
+  }
+
+  bool hasHeader(const String& name) const {
+    return getHeader(name) != nullptr;
+  }
+  AsyncWebHeader* getHeader(const String& name) const;
+  const String& header(const char* name) const;
+
+  bool hasParam(const String& name, bool post = false, bool file = false) const {
+    return getParam(name, post, file) != nullptr;
+  }
+  AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+  const String& arg(const String& name) const;
+
+  // like the library, a request has a single disconnect handler
+  void onDisconnect(ArDisconnectHandler fn) {
+    _disconnectHandler = fn;
+  }
+
+  void send(AsyncWebServerResponse* response);
+  void send(int code, const String& contentType = String(), const String& content = String()) {
+    send(beginResponse(code, contentType, content));
+  }
+  AsyncWebServerResponse* beginResponse(int code,
+                                        const String& contentType = String(),
+                                        const String& content = String()) {
+    return new AsyncBasicResponse(code, contentType, content);
+  }
+  AsyncWebServerResponse* beginResponse(const String& contentType, size_t len, AwsResponseFiller callback) {
+    return new AsyncCallbackResponse(contentType, len, callback);
+  }
+  AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller callback) {
+    return new AsyncCallbackResponse(contentType, 0, callback);
+  }
+
+  // Host only: request construction and response inspection
+  void addHeader(const String& name, const String& value) {
+    _headers.push_back(new AsyncWebHeader(name, value));
+  }
+  void addParam(const String& name, const String& value) {
+    _params.push_back(new AsyncWebParameter(name, value));
+  }
+  void setContentType(const String& contentType) {
+    _contentType = contentType;
+  }
+  const String& body() const {
+    return _body;
+  }
+  AsyncWebServerResponse* response() const {
+    return _response;
+  }
+  // as the device does when the connection is polled, acknowledges a response which has not finished
+  void poll() {
+    if (_response && !_response->_finished()) {
+      _response->_ack(this, 0, 0);
+    }
+  }
+
+  void* _tempObject = nullptr;
+
+ private:
+  WebRequestMethodComposite _method;
+  String _url;
+  String _body;
+  String _contentType;
+  AsyncWebServerResponse* _response;
+  std::vector<AsyncWebHeader*> _headers;
+  std::vector<AsyncWebParameter*> _params;
+  ArDisconnectHandler _disconnectHandler;
+};
+
+class AsyncWebHandler {
+ public:
+  virtual ~AsyncWebHandler() {
+  }
+  AsyncWebHandler& setFilter(ArRequestFilterFunction fn) {
+    _filter = fn;
+    return *this;
+  }
+  bool filter(AsyncWebServerRequest* request) {
+    return _filter == nullptr || _filter(request);
+  }
+  virtual bool canHandle(AsyncWebServerRequest* request) {
+    return false;
+  }
+  virtual void handleRequest(AsyncWebServerRequest* request) {
+  }
+  virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+  }
+
+ protected:
+  ArRequestFilterFunction _filter;
+
+  static bool uriMatches(const String& uri, AsyncWebServerRequest* request) {
+    if (uri.length() && uri.endsWith("*")) {
+      return request->url().startsWith(uri.substring(0, uri.length() - 1));
+    }
+    return uri == request->url() || request->url().startsWith(uri + "/");
+  }
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+ public:
+  AsyncCallbackWebHandler() : _method(HTTP_ANY) {
+  }
+  void setUri(const String& uri) {
+    _uri = uri;
+  }
+  void setMethod(WebRequestMethodComposite method) {
+    _method = method;
+  }
+  void onRequest(ArRequestHandlerFunction fn) {
+    _onRequest = fn;
+  }
+  bool canHandle(AsyncWebServerRequest* request) {
+    return _onRequest && (_method & request->method()) && uriMatches(_uri, request);
+  }
+  void handleRequest(AsyncWebServerRequest* request) {
+    _onRequest(request);
+  }
+
+ private:
+  String _uri;
+  WebRequestMethodComposite _method;
+  ArRequestHandlerFunction _onRequest;
+};
+
+class AsyncWebServer {
+ public:
+  AsyncWebServer(uint16_t port) {
+  }
+  ~AsyncWebServer();
+
+  void begin() {
+  }
+  void end() {
+  }
+
+  AsyncWebHandler& addHandler(AsyncWebHandler* handler) {
+    _handlers.push_back(handler);
+    return *handler;
+  }
+  bool removeHandler(AsyncWebHandler* handler) {
+    _handlers.remove(handler);
+    return true;
+  }
+
+  AsyncCallbackWebHandler& on(const char* uri, ArRequestHandlerFunction onRequest) {
+    return on(uri, HTTP_ANY, onRequest);
+  }
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+  void onNotFound(ArRequestHandlerFunction fn) {
+    _notFound = fn;
+  }
+
+  // Host only: route the request to the first handler which accepts it, as the device does
+  void handleRequest(AsyncWebServerRequest* request);
+
+  // Host only: find a registered WebSocket by path so clients can be attached to it
+  AsyncWebSocket* socket(const String& url);
+
+ private:
+  std::list<AsyncWebHandler*> _handlers;
+  std::list<AsyncCallbackWebHandler*> _ownedHandlers;
+  ArRequestHandlerFunction _notFound;
+};
+
+typedef enum { WS_DISCONNECTED, WS_CONNECTED, WS_DISCONNECTING } AwsClientStatus;
+typedef enum {
+  WS_CONTINUATION,
+  WS_TEXT,
+  WS_BINARY,
+  WS_DISCONNECT = 0x08,
+  WS_PING,
+  WS_PONG
+} AwsFrameType;
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+typedef struct {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+} AwsFrameInfo;
+
+#ifndef WS_MAX_QUEUED_MESSAGES
+#define WS_MAX_QUEUED_MESSAGES 8
+#endif
+
+class AsyncWebSocket;
+
+class AsyncWebSocketMessageBuffer {
+ public:
+  AsyncWebSocketMessageBuffer(size_t size) : _data(size + 1, 0), _count(0), _lock(false) {
+  }
+  uint8_t* get() {
+    return _data.data();
+  }
+  size_t length() const {
+    return _data.size() - 1;
+  }
+  void lock() {
+    _lock = true;
+  }
+  void unlock() {
+    _lock = false;
+  }
+  bool canDelete() const {
+    return !_count && !_lock;
+  }
+
+ private:
+  std::vector<uint8_t> _data;
+  uint32_t _count;
+  bool _lock;
+};
+
+/**
+ * Messages sent to a client are retained in its queue until the host drains them with takeMessages(), modelling a
+ * client whose TCP window only opens when the test says so.
+ */
+class AsyncWebSocketClient {
+ public:
+  AsyncWebSocketClient(AsyncWebSocket* server, uint32_t id) : _server(server), _id(id), _status(WS_CONNECTED) {
+  }
+
+  uint32_t id() const {
+    return _id;
+  }
+  AwsClientStatus status() const {
+    return _status;
+  }
+  AsyncWebSocket* server() {
+    return _server;
+  }
+
+  bool queueIsFull() const {
+    return _queue.size() >= WS_MAX_QUEUED_MESSAGES;
+  }
+  bool canSend() const {
+    return !queueIsFull();
+  }
+  size_t queueLength() const {
+    return _queue.size();
+  }
+
+  void text(const char* message, size_t len);
+  void text(const char* message) {
+    text(message, strlen(message));
+  }
+  void text(const String& message) {
+    text(message.c_str(), message.length());
+  }
+  void text(AsyncWebSocketMessageBuffer* buffer);
+  void close(uint16_t code = 0, const char* message = nullptr);
+
+  // Host only: remove and return the messages queued for this client
+  std::vector<String> takeMessages();
+
+  // Host only: discard the messages queued for this client
+  void clearMessages() {
+    _queue.clear();
+  }
+
+  // Host only: the number of messages discarded because the queue was full
+  size_t droppedMessages() const {
+    return _dropped;
+  }
+
+ private:
+  AsyncWebSocket* _server;
+  uint32_t _id;
+  AwsClientStatus _status;
+  std::list<String> _queue;
+  size_t _dropped = 0;
+
+  friend class AsyncWebSocket;
+};
+
+typedef std::function<
+    void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len)>
+    AwsEventHandler;
+
+class AsyncWebSocket : public AsyncWebHandler {
+ public:
+  AsyncWebSocket(const String& url) : _url(url), _nextId(1) {
+  }
+  ~AsyncWebSocket();
+
+  const char* url() const {
+    return _url.c_str();
+  }
+  void onEvent(AwsEventHandler handler) {
+    _eventHandler = handler;
+  }
+
+  size_t count() const;
+  AsyncWebSocketClient* client(uint32_t id);
+  bool hasClient(uint32_t id) {
+    return client(id) != nullptr;
+  }
+  std::list<AsyncWebSocketClient*>& getClients() {
+    return _clients;
+  }
+  void cleanupClients(uint16_t maxClients = 8) {
+  }
+
+  AsyncWebSocketMessageBuffer* makeBuffer(size_t size = 0) {
+    AsyncWebSocketMessageBuffer* buffer = new AsyncWebSocketMessageBuffer(size);
+    _buffers.push_back(buffer);
+    return buffer;
+  }
+  void text(uint32_t id, const char* message) {
+    AsyncWebSocketClient* c = client(id);
+    if (c) {
+      c->text(message);
+    }
+  }
+  void textAll(const char* message, size_t len);
+  void textAll(const char* message) {
+    textAll(message, strlen(message));
+  }
+  void textAll(const String& message) {
+    textAll(message.c_str(), message.length());
+  }
+  void textAll(AsyncWebSocketMessageBuffer* buffer);
+
+  bool canHandle(AsyncWebServerRequest* request) {
+    return request->method() == HTTP_GET && request->url() == _url;
+  }
+
+  // Host only: simulate clients connecting, sending text frames and disconnecting
+  AsyncWebSocketClient* connect(AsyncWebServerRequest* request = nullptr);
+  void receive(AsyncWebSocketClient* client, const String& message);
+  void disconnect(AsyncWebSocketClient* client);
+
+ private:
+  String _url;
+  uint32_t _nextId;
+  AwsEventHandler _eventHandler;
+  std::list<AsyncWebSocketClient*> _clients;
+  std::list<AsyncWebSocketMessageBuffer*> _buffers;
+
+  void cleanBuffers();
+
+  friend class AsyncWebSocketClient;
+};
+
+class DefaultHeaders {
+ public:
+  void addHeader(const String& name, const String& value) {
+  }
+  static DefaultHeaders& Instance() {
+    static DefaultHeaders instance;
+    return instance;
+  }
+};
+
+#endif  // end ESPAsyncWebServer_h
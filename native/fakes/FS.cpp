@@ -0,0 +1,103 @@
+#include <FS.h>
+#include <LittleFS.h>
+
+fs::FS LittleFS;
+
+namespace fs {
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+  if (!_data || !_writable) {
+    return 0;
+  }
+  if (_position + size > _data->size()) {
+    _data->resize(_position + size);
+  }
+  memcpy(_data->data() + _position, buffer, size);
+  _position += size;
+  *_bytesWritten += size;
+  return size;
+}
+
+size_t File::readBytes(char* buffer, size_t length) {
+  size_t count = std::min(length, (size_t)available());
+  if (count) {
+    memcpy(buffer, _data->data() + _position, count);
+    _position += count;
+  }
+  return count;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!_data) {
+    return false;
+  }
+  size_t target = mode == SeekSet ? pos : mode == SeekCur ? _position + pos : _data->size() + pos;
+  if (target > _data->size()) {
+    return false;
+  }
+  _position = target;
+  return true;
+}
+
+bool FS::info(FSInfo& info) {
+  size_t used = 0;
+  for (auto& file : _files) {
+    used += file.second->size();
+  }
+  info.totalBytes = 1024 * 1024;
+  info.usedBytes = used;
+  info.blockSize = 8192;
+  info.pageSize = 256;
+  info.maxOpenFiles = 5;
+  info.maxPathLength = 32;
+  return true;
+}
+
+File FS::open(const String& path, const char* mode) {
+  auto entry = _files.find(path.c_str());
+  if (mode[0] == 'r') {
+    if (entry == _files.end()) {
+      return File();
+    }
+    return File(path, entry->second, mode[1] == '+', &_bytesWritten);
+  }
+  if (entry == _files.end()) {
+    entry = _files.insert(std::make_pair(std::string(path.c_str()), std::make_shared<FileData>())).first;
+  } else if (mode[0] == 'w') {
+    // truncate by replacing the contents, handles opened for reading keep their copy
+    entry->second = std::make_shared<FileData>();
+  }
+  File file(path, entry->second, true, &_bytesWritten);
+  if (mode[0] == 'a') {
+    file.seek(0, SeekEnd);
+  }
+  return file;
+}
+
+Dir FS::openDir(const String& path) {
+  String prefix = path;
+  if (!prefix.endsWith("/")) {
+    prefix += "/";
+  }
+  std::vector<String> entries;
+  for (auto& file : _files) {
+    String filePath(file.first);
+    if (filePath.startsWith(prefix) && filePath.indexOf('/', prefix.length()) < 0) {
+      entries.push_back(filePath.substring(prefix.length()));
+    }
+  }
+  return Dir(entries);
+}
+
+bool FS::rename(const String& pathFrom, const String& pathTo) {
+  auto entry = _files.find(pathFrom.c_str());
+  if (entry == _files.end()) {
+    return false;
+  }
+  std::shared_ptr<FileData> data = entry->second;
+  _files.erase(entry);
+  _files[pathTo.c_str()] = data;
+  return true;
+}
+
+}  // namespace fs
@@ -0,0 +1,158 @@
+#ifndef FS_h
+#define FS_h
+
+#include <Arduino.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+typedef std::vector<uint8_t> FileData;
+
+class File : public Stream {
+ public:
+  File() : _position(0), _writable(false), _bytesWritten(nullptr) {
+  }
+  File(const String& name, std::shared_ptr<FileData> data, bool writable, size_t* bytesWritten) :
+      _name(name), _data(data), _position(0), _writable(writable), _bytesWritten(bytesWritten) {
+  }
+
+  size_t write(uint8_t c) {
+    return write(&c, 1);
+  }
+  size_t write(const uint8_t* buffer, size_t size);
+  using Print::write;
+
+  int available() {
+    return _data ? (int)(_data->size() - _position) : 0;
+  }
+  int read() {
+    return available() > 0 ? (*_data)[_position++] : -1;
+  }
+  int peek() {
+    return available() > 0 ? (*_data)[_position] : -1;
+  }
+  size_t read(uint8_t* buffer, size_t size) {
+    return readBytes((char*)buffer, size);
+  }
+  size_t readBytes(char* buffer, size_t length);
+  using Stream::readBytes;
+
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const {
+    return _position;
+  }
+  size_t size() const {
+    return _data ? _data->size() : 0;
+  }
+  void flush() {
+  }
+  void close() {
+    _data.reset();
+  }
+  const char* name() const {
+    return _name.c_str();
+  }
+  operator bool() const {
+    return (bool)_data;
+  }
+
+ private:
+  String _name;
+  std::shared_ptr<FileData> _data;
+  size_t _position;
+  bool _writable;
+  size_t* _bytesWritten;
+};
+
+class Dir {
+ public:
+  Dir() : _index(-1) {
+  }
+  Dir(std::vector<String> entries) : _entries(entries), _index(-1) {
+  }
+
+  bool next() {
+    return ++_index < (int)_entries.size();
+  }
+  String fileName() {
+    return _entries[_index];
+  }
+
+ private:
+  std::vector<String> _entries;
+  int _index;
+};
+
+/**
+ * In-memory filesystem with the ESP8266 FS API. Files live in a flat map keyed by their full path, directories are
+ * implied by the paths of the files they contain.
+ */
+class FS {
+ public:
+  FS() : _bytesWritten(0) {
+  }
+
+  bool begin() {
+    return true;
+  }
+  void end() {
+  }
+  bool format() {
+    _files.clear();
+    return true;
+  }
+  bool info(FSInfo& info);
+
+  File open(const String& path, const char* mode);
+  bool exists(const String& path) {
+    return _files.count(path.c_str()) > 0;
+  }
+  Dir openDir(const String& path);
+  bool remove(const String& path) {
+    return _files.erase(path.c_str()) > 0;
+  }
+  bool rename(const String& pathFrom, const String& pathTo);
+  bool mkdir(const String& path) {
+    return true;
+  }
+  bool rmdir(const String& path) {
+    return true;
+  }
+
+  // Host only: total bytes written to the filesystem, used to measure flash wear
+  size_t bytesWritten() const {
+    return _bytesWritten;
+  }
+
+ private:
+  std::map<std::string, std::shared_ptr<FileData>> _files;
+  size_t _bytesWritten;
+};
+
+}  // namespace fs
+
+using fs::Dir;
+using fs::File;
+using fs::FS;
+using fs::FSInfo;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekMode;
+using fs::SeekSet;
+
+#endif  // end FS_h
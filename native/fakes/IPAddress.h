@@ -0,0 +1,54 @@
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include <stdio.h>
+
+#include <Arduino.h>
+
+class IPAddress {
+ public:
+  IPAddress() : _address(0) {
+  }
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) :
+      _address((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {
+  }
+  IPAddress(uint32_t address) : _address(address) {
+  }
+
+  operator uint32_t() const {
+    return _address;
+  }
+  bool operator==(const IPAddress& rhs) const {
+    return _address == rhs._address;
+  }
+  bool operator!=(const IPAddress& rhs) const {
+    return _address != rhs._address;
+  }
+  uint8_t operator[](int index) const {
+    return (_address >> (8 * index)) & 0xFF;
+  }
+
+  bool fromString(const String& address) {
+    unsigned int a, b, c, d;
+    char trailing;
+    if (sscanf(address.c_str(), "%u.%u.%u.%u%c", &a, &b, &c, &d, &trailing) != 4 || a > 255 || b > 255 || c > 255 ||
+        d > 255) {
+      return false;
+    }
+    *this = IPAddress(a, b, c, d);
+    return true;
+  }
+
+  String toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buffer);
+  }
+
+ private:
+  uint32_t _address;
+};
+
+#define INADDR_NONE IPAddress(0, 0, 0, 0)
+
+#endif  // end IPAddress_h
@@ -0,0 +1,8 @@
+#ifndef LittleFS_h
+#define LittleFS_h
+
+#include <FS.h>
+
+extern fs::FS LittleFS;
+
+#endif  // end LittleFS_h
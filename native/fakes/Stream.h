@@ -0,0 +1,41 @@
+#ifndef Stream_h
+#define Stream_h
+
+#include <Print.h>
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  virtual size_t readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = read();
+      if (c < 0) {
+        break;
+      }
+      *buffer++ = (char)c;
+      count++;
+    }
+    return count;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) {
+    return readBytes((char*)buffer, length);
+  }
+
+  String readString() {
+    String result;
+    int c;
+    while ((c = read()) >= 0) {
+      result += (char)c;
+    }
+    return result;
+  }
+
+  void setTimeout(unsigned long timeout) {
+  }
+};
+
+#endif  // end Stream_h
@@ -0,0 +1,232 @@
+#include <WString.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+static std::string formatUnsigned(unsigned long value, unsigned char base) {
+  if (base < 2 || base > 36) {
+    base = 10;
+  }
+  char buffer[8 * sizeof(unsigned long) + 1];
+  char* p = &buffer[sizeof(buffer) - 1];
+  *p = 0;
+  do {
+    unsigned long digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value);
+  return std::string(p);
+}
+
+static std::string formatSigned(long value, unsigned char base) {
+  if (value < 0 && base == 10) {
+    return "-" + formatUnsigned(-(unsigned long)value, base);
+  }
+  return formatUnsigned((unsigned long)value, base);
+}
+
+static std::string formatFloat(double value, unsigned char decimalPlaces) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+  return std::string(buffer);
+}
+
+String::String(unsigned char value, unsigned char base) : _buffer(formatUnsigned(value, base)) {
+}
+
+String::String(int value, unsigned char base) : _buffer(formatSigned(value, base)) {
+}
+
+String::String(unsigned int value, unsigned char base) : _buffer(formatUnsigned(value, base)) {
+}
+
+String::String(long value, unsigned char base) : _buffer(formatSigned(value, base)) {
+}
+
+String::String(unsigned long value, unsigned char base) : _buffer(formatUnsigned(value, base)) {
+}
+
+String::String(float value, unsigned char decimalPlaces) : _buffer(formatFloat(value, decimalPlaces)) {
+}
+
+String::String(double value, unsigned char decimalPlaces) : _buffer(formatFloat(value, decimalPlaces)) {
+}
+
+unsigned char String::equalsIgnoreCase(const String& s) const {
+  if (_buffer.length() != s._buffer.length()) {
+    return 0;
+  }
+  for (size_t i = 0; i < _buffer.length(); i++) {
+    if (tolower(_buffer[i]) != tolower(s._buffer[i])) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+unsigned char String::startsWith(const String& prefix, unsigned int offset) const {
+  if (offset > _buffer.length()) {
+    return 0;
+  }
+  return _buffer.compare(offset, prefix._buffer.length(), prefix._buffer) == 0;
+}
+
+unsigned char String::endsWith(const String& suffix) const {
+  if (suffix._buffer.length() > _buffer.length()) {
+    return 0;
+  }
+  return _buffer.compare(_buffer.length() - suffix._buffer.length(), suffix._buffer.length(), suffix._buffer) == 0;
+}
+
+void String::toCharArray(char* buf, unsigned int bufsize, unsigned int index) const {
+  if (!bufsize || !buf) {
+    return;
+  }
+  if (index >= _buffer.length()) {
+    buf[0] = 0;
+    return;
+  }
+  size_t n = std::min((size_t)bufsize - 1, _buffer.length() - index);
+  memcpy(buf, _buffer.c_str() + index, n);
+  buf[n] = 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+  size_t pos = _buffer.find(ch, fromIndex);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+  size_t pos = _buffer.find(str._buffer, fromIndex);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch) const {
+  size_t pos = _buffer.rfind(ch);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& str) const {
+  size_t pos = _buffer.rfind(str._buffer);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) {
+    std::swap(beginIndex, endIndex);
+  }
+  if (beginIndex >= _buffer.length()) {
+    return String();
+  }
+  endIndex = std::min(endIndex, (unsigned int)_buffer.length());
+  return String(_buffer.substr(beginIndex, endIndex - beginIndex));
+}
+
+void String::replace(char find, char replace) {
+  std::replace(_buffer.begin(), _buffer.end(), find, replace);
+}
+
+void String::replace(const String& find, const String& replace) {
+  if (find._buffer.empty()) {
+    return;
+  }
+  size_t pos = 0;
+  while ((pos = _buffer.find(find._buffer, pos)) != std::string::npos) {
+    _buffer.replace(pos, find._buffer.length(), replace._buffer);
+    pos += replace._buffer.length();
+  }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < _buffer.length()) {
+    _buffer.erase(index, count);
+  }
+}
+
+void String::toLowerCase() {
+  std::transform(_buffer.begin(), _buffer.end(), _buffer.begin(), ::tolower);
+}
+
+void String::toUpperCase() {
+  std::transform(_buffer.begin(), _buffer.end(), _buffer.begin(), ::toupper);
+}
+
+void String::trim() {
+  size_t first = _buffer.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos) {
+    _buffer.clear();
+    return;
+  }
+  size_t last = _buffer.find_last_not_of(" \t\r\n");
+  _buffer = _buffer.substr(first, last - first + 1);
+}
+
+long String::toInt() const {
+  return strtol(_buffer.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+  return strtof(_buffer.c_str(), nullptr);
+}
+
+double String::toDouble() const {
+  return strtod(_buffer.c_str(), nullptr);
+}
+
+StringSumHelper operator+(const String& lhs, const String& rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const String& lhs, const char* rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const char* lhs, const String& rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const String& lhs, char rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(char lhs, const String& rhs) {
+  StringSumHelper result{String(lhs)};
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const String& lhs, int rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const String& lhs, unsigned int rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const String& lhs, long rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const String& lhs, unsigned long rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
@@ -0,0 +1,228 @@
+#ifndef WString_h
+#define WString_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+class StringSumHelper;
+
+/**
+ * Host stand-in for the Arduino String class, backed by std::string.
+ *
+ * Only the parts of the Arduino API used by the framework and ArduinoJson are provided.
+ */
+class String {
+ public:
+  String() {
+  }
+  String(const char* cstr) : _buffer(cstr ? cstr : "") {
+  }
+  String(const char* cstr, size_t length) : _buffer(cstr, length) {
+  }
+  String(const std::string& str) : _buffer(str) {
+  }
+  String(const String& str) : _buffer(str._buffer) {
+  }
+  String(String&& str) : _buffer(std::move(str._buffer)) {
+  }
+  explicit String(char c) : _buffer(1, c) {
+  }
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+
+  String& operator=(const String& rhs) {
+    _buffer = rhs._buffer;
+    return *this;
+  }
+  String& operator=(String&& rhs) {
+    _buffer = std::move(rhs._buffer);
+    return *this;
+  }
+  String& operator=(const char* cstr) {
+    _buffer = cstr ? cstr : "";
+    return *this;
+  }
+
+  unsigned char reserve(unsigned int size) {
+    _buffer.reserve(size);
+    return 1;
+  }
+  unsigned int length() const {
+    return _buffer.length();
+  }
+  bool isEmpty() const {
+    return _buffer.empty();
+  }
+  const char* c_str() const {
+    return _buffer.c_str();
+  }
+  char* begin() {
+    return &_buffer[0];
+  }
+  char* end() {
+    return &_buffer[0] + _buffer.length();
+  }
+
+  unsigned char concat(const String& str) {
+    _buffer += str._buffer;
+    return 1;
+  }
+  unsigned char concat(const char* cstr) {
+    if (cstr) {
+      _buffer += cstr;
+    }
+    return 1;
+  }
+  unsigned char concat(const char* cstr, unsigned int length) {
+    _buffer.append(cstr, length);
+    return 1;
+  }
+  unsigned char concat(char c) {
+    _buffer += c;
+    return 1;
+  }
+  unsigned char concat(int value) {
+    return concat(String(value));
+  }
+  unsigned char concat(unsigned int value) {
+    return concat(String(value));
+  }
+  unsigned char concat(long value) {
+    return concat(String(value));
+  }
+  unsigned char concat(unsigned long value) {
+    return concat(String(value));
+  }
+
+  String& operator+=(const String& rhs) {
+    concat(rhs);
+    return *this;
+  }
+  String& operator+=(const char* cstr) {
+    concat(cstr);
+    return *this;
+  }
+  String& operator+=(char c) {
+    concat(c);
+    return *this;
+  }
+  String& operator+=(int value) {
+    concat(value);
+    return *this;
+  }
+  String& operator+=(unsigned int value) {
+    concat(value);
+    return *this;
+  }
+  String& operator+=(long value) {
+    concat(value);
+    return *this;
+  }
+  String& operator+=(unsigned long value) {
+    concat(value);
+    return *this;
+  }
+
+  int compareTo(const String& s) const {
+    return _buffer.compare(s._buffer);
+  }
+  unsigned char equals(const String& s) const {
+    return _buffer == s._buffer;
+  }
+  unsigned char equals(const char* cstr) const {
+    return _buffer == (cstr ? cstr : "");
+  }
+  unsigned char equalsIgnoreCase(const String& s) const;
+  unsigned char operator==(const String& rhs) const {
+    return equals(rhs);
+  }
+  unsigned char operator==(const char* cstr) const {
+    return equals(cstr);
+  }
+  unsigned char operator!=(const String& rhs) const {
+    return !equals(rhs);
+  }
+  unsigned char operator!=(const char* cstr) const {
+    return !equals(cstr);
+  }
+  unsigned char operator<(const String& rhs) const {
+    return compareTo(rhs) < 0;
+  }
+  unsigned char startsWith(const String& prefix) const {
+    return _buffer.compare(0, prefix._buffer.length(), prefix._buffer) == 0;
+  }
+  unsigned char startsWith(const String& prefix, unsigned int offset) const;
+  unsigned char endsWith(const String& suffix) const;
+
+  char charAt(unsigned int index) const {
+    return index < _buffer.length() ? _buffer[index] : 0;
+  }
+  void setCharAt(unsigned int index, char c) {
+    if (index < _buffer.length()) {
+      _buffer[index] = c;
+    }
+  }
+  char operator[](unsigned int index) const {
+    return charAt(index);
+  }
+  char& operator[](unsigned int index) {
+    return _buffer[index];
+  }
+  void toCharArray(char* buf, unsigned int bufsize, unsigned int index = 0) const;
+  void getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index = 0) const {
+    toCharArray((char*)buf, bufsize, index);
+  }
+
+  int indexOf(char ch, unsigned int fromIndex = 0) const;
+  int indexOf(const String& str, unsigned int fromIndex = 0) const;
+  int lastIndexOf(char ch) const;
+  int lastIndexOf(const String& str) const;
+  String substring(unsigned int beginIndex) const {
+    return substring(beginIndex, _buffer.length());
+  }
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  void replace(char find, char replace);
+  void replace(const String& find, const String& replace);
+  void remove(unsigned int index) {
+    remove(index, (unsigned int)-1);
+  }
+  void remove(unsigned int index, unsigned int count);
+  void toLowerCase();
+  void toUpperCase();
+  void trim();
+
+  long toInt() const;
+  float toFloat() const;
+  double toDouble() const;
+
+ protected:
+  std::string _buffer;
+};
+
+class StringSumHelper : public String {
+ public:
+  StringSumHelper(const String& s) : String(s) {
+  }
+  StringSumHelper(const char* p) : String(p) {
+  }
+};
+
+StringSumHelper operator+(const String& lhs, const String& rhs);
+StringSumHelper operator+(const String& lhs, const char* rhs);
+StringSumHelper operator+(const char* lhs, const String& rhs);
+StringSumHelper operator+(const String& lhs, char rhs);
+StringSumHelper operator+(char lhs, const String& rhs);
+StringSumHelper operator+(const String& lhs, int rhs);
+StringSumHelper operator+(const String& lhs, unsigned int rhs);
+StringSumHelper operator+(const String& lhs, long rhs);
+StringSumHelper operator+(const String& lhs, unsigned long rhs);
+
+#endif  // end WString_h
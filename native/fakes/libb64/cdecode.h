@@ -0,0 +1,26 @@
+#ifndef BASE64_CDECODE_H
+#define BASE64_CDECODE_H
+
+// Host implementation of the libb64 decoder API bundled with the ESP8266 core
+
+#define base64_decode_expected_len(n) ((n * 3) / 4)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  int pending;
+  unsigned int bits;
+} base64_decodestate;
+
+void base64_init_decodestate(base64_decodestate* state_in);
+int base64_decode_value(char value_in);
+int base64_decode_block(const char* code_in, const int length_in, char* plaintext_out, base64_decodestate* state_in);
+int base64_decode_chars(const char* code_in, const int length_in, char* plaintext_out);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // end BASE64_CDECODE_H
@@ -0,0 +1,33 @@
+#ifndef BASE64_CENCODE_H
+#define BASE64_CENCODE_H
+
+// Host implementation of the libb64 encoder API bundled with the ESP8266 core
+
+#define BASE64_CHARS_PER_LINE 72
+
+#define base64_encode_expected_len_nonewlines(n) ((((4 * (n)) / 3) + 3) & ~3)
+#define base64_encode_expected_len(n) \
+  (base64_encode_expected_len_nonewlines(n) + ((n / ((BASE64_CHARS_PER_LINE * 3) / 4)) + 1))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  int pending;
+  unsigned char buffer[2];
+  int charsPerLine;
+  int lineLength;
+} base64_encodestate;
+
+void base64_init_encodestate(base64_encodestate* state_in);
+void base64_init_encodestate_nonewlines(base64_encodestate* state_in);
+int base64_encode_block(const char* plaintext_in, int length_in, char* code_out, base64_encodestate* state_in);
+int base64_encode_blockend(char* code_out, base64_encodestate* state_in);
+int base64_encode_chars(const char* plaintext_in, int length_in, char* code_out);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // end BASE64_CENCODE_H
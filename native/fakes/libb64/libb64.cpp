@@ -0,0 +1,117 @@
+#include <libb64/cdecode.h>
+#include <libb64/cencode.h>
+
+static const char* ENCODING = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int emit(char* code_out, int& len, char c, base64_encodestate* state_in) {
+  code_out[len++] = c;
+  if (state_in->charsPerLine && ++state_in->lineLength == state_in->charsPerLine) {
+    code_out[len++] = '\n';
+    state_in->lineLength = 0;
+  }
+  return len;
+}
+
+void base64_init_encodestate(base64_encodestate* state_in) {
+  state_in->pending = 0;
+  state_in->charsPerLine = BASE64_CHARS_PER_LINE;
+  state_in->lineLength = 0;
+}
+
+void base64_init_encodestate_nonewlines(base64_encodestate* state_in) {
+  base64_init_encodestate(state_in);
+  state_in->charsPerLine = 0;
+}
+
+int base64_encode_block(const char* plaintext_in, int length_in, char* code_out, base64_encodestate* state_in) {
+  int len = 0;
+  for (int i = 0; i < length_in; i++) {
+    unsigned char c = (unsigned char)plaintext_in[i];
+    if (state_in->pending < 2) {
+      state_in->buffer[state_in->pending++] = c;
+      continue;
+    }
+    unsigned char* b = state_in->buffer;
+    emit(code_out, len, ENCODING[b[0] >> 2], state_in);
+    emit(code_out, len, ENCODING[((b[0] & 0x03) << 4) | (b[1] >> 4)], state_in);
+    emit(code_out, len, ENCODING[((b[1] & 0x0f) << 2) | (c >> 6)], state_in);
+    emit(code_out, len, ENCODING[c & 0x3f], state_in);
+    state_in->pending = 0;
+  }
+  return len;
+}
+
+int base64_encode_blockend(char* code_out, base64_encodestate* state_in) {
+  int len = 0;
+  unsigned char* b = state_in->buffer;
+  if (state_in->pending == 1) {
+    emit(code_out, len, ENCODING[b[0] >> 2], state_in);
+    emit(code_out, len, ENCODING[(b[0] & 0x03) << 4], state_in);
+    emit(code_out, len, '=', state_in);
+    emit(code_out, len, '=', state_in);
+  } else if (state_in->pending == 2) {
+    emit(code_out, len, ENCODING[b[0] >> 2], state_in);
+    emit(code_out, len, ENCODING[((b[0] & 0x03) << 4) | (b[1] >> 4)], state_in);
+    emit(code_out, len, ENCODING[(b[1] & 0x0f) << 2], state_in);
+    emit(code_out, len, '=', state_in);
+  }
+  state_in->pending = 0;
+  return len;
+}
+
+int base64_encode_chars(const char* plaintext_in, int length_in, char* code_out) {
+  base64_encodestate state;
+  base64_init_encodestate(&state);
+  int len = base64_encode_block(plaintext_in, length_in, code_out, &state);
+  len += base64_encode_blockend(code_out + len, &state);
+  code_out[len] = 0;
+  return len;
+}
+
+void base64_init_decodestate(base64_decodestate* state_in) {
+  state_in->pending = 0;
+  state_in->bits = 0;
+}
+
+int base64_decode_value(char value_in) {
+  if (value_in >= 'A' && value_in <= 'Z') {
+    return value_in - 'A';
+  }
+  if (value_in >= 'a' && value_in <= 'z') {
+    return value_in - 'a' + 26;
+  }
+  if (value_in >= '0' && value_in <= '9') {
+    return value_in - '0' + 52;
+  }
+  if (value_in == '+') {
+    return 62;
+  }
+  if (value_in == '/') {
+    return 63;
+  }
+  return -1;
+}
+
+int base64_decode_block(const char* code_in, const int length_in, char* plaintext_out, base64_decodestate* state_in) {
+  int len = 0;
+  for (int i = 0; i < length_in; i++) {
+    int value = base64_decode_value(code_in[i]);
+    if (value < 0) {
+      // padding, newlines and invalid characters are skipped
+      continue;
+    }
+    state_in->bits = (state_in->bits << 6) | (unsigned int)value;
+    state_in->pending += 6;
+    if (state_in->pending >= 8) {
+      state_in->pending -= 8;
+      plaintext_out[len++] = (char)((state_in->bits >> state_in->pending) & 0xff);
+    }
+  }
+  return len;
+}
+
+int base64_decode_chars(const char* code_in, const int length_in, char* plaintext_out) {
+  base64_decodestate state;
+  base64_init_decodestate(&state);
+  return base64_decode_block(code_in, length_in, plaintext_out, &state);
+}
@@ -0,0 +1,773 @@
+#include <BatchEndpoint.h>
+#include <BootProfile.h>
+#include <ESPFS.h>
+#include <LightMqttSettingsService.h>
+#include <LightStateService.h>
+#include <SecuritySettingsService.h>
+#include <WebSocketHub.h>
+
+#include <stdio.h>
+
+#define HOST_WRITE_BEHIND_FILE "/config/writeBehind.json"
+#define HOST_WRITE_BEHIND_QUIET_PERIOD 20
+#define HOST_WRITE_BEHIND_MAX_DELAY 1000
+#define HOST_CONFIG_STORE_FILE "/config/host.log"
+#define HOST_MIGRATED_FILE "/config/migrated.json"
+#define HOST_OVERLONG_FILE "/config/overlong.json"
+#define HOST_STREAMED_PATH "/rest/streamed"
+#define HOST_STREAMED_BUFFER_SIZE 4096
+#define HOST_STREAMED_NAME_LENGTH 3000
+#define HOST_DELTA_SOCKET_PATH "/ws/delta"
+#define HOST_SLOW_SOCKET_PATH "/ws/slow"
+
+/**
+ * Host runner for the native environment.
+ *
+ * Wires the security settings and demo light services to the in-process fakes and drives them through the same
+ * paths a device would see: REST requests, a WebSocket client, MQTT messages and filesystem persistence. The exit
+ * code is non-zero if any of the scripted checks fail, so the runner can be used as a smoke test.
+ */
+
+static int failures = 0;
+
+static void check(bool condition, const char* description) {
+  printf("%s %s\n", condition ? "[ OK ]" : "[FAIL]", description);
+  if (!condition) {
+    failures++;
+  }
+}
+
+// reads a string member of a persisted state, in whichever format it was written
+static String readPersisted(const char* filePath, const char* key, JsonFileFormat* format = nullptr) {
+  DynamicJsonDocument jsonDocument(DEFAULT_BUFFER_SIZE);
+  JsonFileFormat fileFormat;
+#if FS_PERSISTENCE_CONFIG_STORE
+  if (!ConfigStore::forFS(&ESPFS)->read(filePath, jsonDocument, fileFormat)) {
+    return String();
+  }
+#else
+  File file = ESPFS.open(filePath, "r");
+  if (!file || ChecksumFile::read(jsonDocument, file, fileFormat) != DeserializationError::Ok) {
+    return String();
+  }
+#endif
+  if (format) {
+    *format = fileFormat;
+  }
+  return jsonDocument[key] | "";
+}
+
+static AsyncWebServerResponse* serve(AsyncWebServer& server, AsyncWebServerRequest& request, const String& jwt) {
+  request.addHeader(AUTHORIZATION_HEADER, AUTHORIZATION_HEADER_PREFIX + jwt);
+  server.handleRequest(&request);
+  return request.response();
+}
+
+int main() {
+  AsyncWebServer server(80);
+  AsyncMqttClient mqttClient;
+  SecuritySettingsService securitySettingsService(&server, &ESPFS);
+  LightMqttSettingsService lightMqttSettingsService(&server, &ESPFS, &securitySettingsService);
+  LightStateService lightStateService(&server, &securitySettingsService, &mqttClient, &lightMqttSettingsService);
+  PersistenceStats persistenceStats(&server, &securitySettingsService);
+  BootProfile bootProfile(&server, &securitySettingsService);
+  WebSocketStats webSocketStats(&server, &securitySettingsService);
+  BatchEndpoint batchEndpoint(&server, &securitySettingsService);
+  WebSocketHub webSocketHub(&server, &securitySettingsService);
+
+  BootProfile::measure("security_settings", [&]() { securitySettingsService.begin(); });
+  lightStateService.begin();
+  lightMqttSettingsService.begin();
+  server.begin();
+  BootProfile::mark("server_started");
+  // marked again, as a reconnection would, which must not move the event recorded at boot
+  BootProfile::mark("server_started");
+
+  User admin(FACTORY_ADMIN_USERNAME, FACTORY_ADMIN_PASSWORD, true);
+  String jwt = securitySettingsService.generateJWT(&admin);
+
+  // boot profile
+  {
+    AsyncWebServerRequest request(HTTP_GET, BOOT_PROFILE_SERVICE_PATH);
+    AsyncWebServerResponse* response = serve(server, request, jwt);
+    DynamicJsonDocument profile(DEFAULT_BUFFER_SIZE);
+    deserializeJson(profile, response ? response->content() : String());
+    JsonArray events = profile["events"];
+    check(String(events[0]["name"] | "") == "security_settings" && String(events[1]["name"] | "") == "server_started",
+          "boot profile records the events in order");
+    check(events.size() == 2, "boot profile ignores an event marked a second time");
+  }
+
+  // REST
+  {
+    AsyncWebServerRequest request(HTTP_GET, LIGHT_SETTINGS_ENDPOINT_PATH);
+    server.handleRequest(&request);
+    check(request.response() && request.response()->code() == 401, "unauthenticated GET is rejected");
+  }
+  {
+    AsyncWebServerRequest request(HTTP_GET, LIGHT_SETTINGS_ENDPOINT_PATH);
+    AsyncWebServerResponse* response = serve(server, request, jwt);
+    check(response && response->code() == 200, "authenticated GET succeeds");
+    check(response && response->content() == "{\"led_on\":false}", "GET returns the initial state");
+    const AsyncWebHeader* etag = response ? response->header("ETag") : nullptr;
+    check(etag != nullptr, "GET tags the state with its revision");
+    if (etag) {
+      AsyncWebServerRequest revalidation(HTTP_GET, LIGHT_SETTINGS_ENDPOINT_PATH);
+      revalidation.addHeader("If-None-Match", etag->value());
+      response = serve(server, revalidation, jwt);
+      check(response && response->code() == 304, "GET of an unchanged revision is not modified");
+    }
+  }
+  {
+    AsyncWebServerRequest request(HTTP_POST, LIGHT_SETTINGS_ENDPOINT_PATH, "{\"led_on\":true}");
+    AsyncWebServerResponse* response = serve(server, request, jwt);
+    check(response && response->code() == 200, "POST succeeds");
+  }
+  bool ledOn = false;
+  lightStateService.read([&](LightState& state) { ledOn = state.ledOn; });
+  check(ledOn, "POST updates the state");
+  {
+    AsyncWebServerRequest request(HTTP_GET, LIGHT_SETTINGS_ENDPOINT_PATH);
+    AsyncWebServerResponse* response = serve(server, request, jwt);
+    check(response && response->content() == "{\"led_on\":true}", "GET returns the updated state");
+  }
+
+  // long-poll requests are held until the revision moves past the client's
+  {
+    AsyncWebServerRequest request(HTTP_GET, LIGHT_SETTINGS_POLL_PATH);
+    AsyncWebServerResponse* response = serve(server, request, jwt);
+    const AsyncWebHeader* etag = response ? response->header("ETag") : nullptr;
+    check(etag != nullptr, "long-poll without an ETag is answered at once");
+    if (etag) {
+      AsyncWebServerRequest held(HTTP_GET, LIGHT_SETTINGS_POLL_PATH);
+      held.addHeader("If-None-Match", etag->value());
+      AsyncWebServerResponse* heldResponse = serve(server, held, jwt);
+      check(heldResponse && !heldResponse->_started(), "long-poll of the current revision is held");
+      held.poll();
+      check(heldResponse && !heldResponse->_started(), "long-poll is held while the state is unchanged");
+      lightStateService.update(
+          [&](LightState& state) {
+            state.ledOn = !state.ledOn;
+            return StateUpdateResult::CHANGED;
+          },
+          "host");
+      held.poll();
+      check(heldResponse && heldResponse->_started() && heldResponse->code() == 200 && heldResponse->header("ETag") &&
+                heldResponse->header("ETag")->value() != etag->value(),
+            "long-poll is answered with the new revision");
+      check(heldResponse && heldResponse->content() == "{\"led_on\":false}",
+            "long-poll is answered with the new state");
+      lightStateService.update(
+          [&](LightState& state) {
+            state.ledOn = !state.ledOn;
+            return StateUpdateResult::CHANGED;
+          },
+          "host");
+
+      AsyncWebServerRequest timedOut(HTTP_GET, LIGHT_SETTINGS_POLL_PATH);
+      String currentTag = "\"" + String(lightStateService.getRevision(), HEX) + "\"";
+      timedOut.addHeader("If-None-Match", currentTag);
+      timedOut.addParam(LONG_POLL_TIMEOUT_PARAMETER, "1");
+      serve(server, timedOut, jwt);
+      for (uint8_t i = 0; i < LONG_POLL_MAX_PENDING; i++) {
+        // a client which disconnects is forgotten
+        AsyncWebServerRequest abandoned(HTTP_GET, LIGHT_SETTINGS_POLL_PATH);
+        abandoned.addHeader("If-None-Match", currentTag);
+        AsyncWebServerResponse* response = serve(server, abandoned, jwt);
+        if (i == LONG_POLL_MAX_PENDING - 1) {
+          check(response && !response->_started(), "long-polls abandoned by their clients are no longer held");
+        }
+      }
+      delay(1000);
+      LoopHook::loopAll();
+      timedOut.poll();
+      check(timedOut.response() && timedOut.response()->_started() && timedOut.response()->code() == 304,
+            "long-poll times out as not modified");
+    }
+  }
+
+  // WebSocket
+  AsyncWebSocket* socket = server.socket(LIGHT_SETTINGS_SOCKET_PATH);
+  check(socket != nullptr, "WebSocket endpoint is registered");
+  if (socket) {
+    // the state changes without a broadcast, as it does when a service loads its settings
+    {
+      for (const char* update : {"{\"led_on\":false}", "{\"led_on\":true}"}) {
+        DynamicJsonDocument unbroadcast(DEFAULT_BUFFER_SIZE);
+        deserializeJson(unbroadcast, update);
+        JsonObject root = unbroadcast.as<JsonObject>();
+        lightStateService.updateWithoutPropagation(root, LightState::update);
+      }
+    }
+    AsyncWebServerRequest upgrade(HTTP_GET, LIGHT_SETTINGS_SOCKET_PATH);
+    upgrade.addParam(ACCESS_TOKEN_PARAMATER, jwt);
+    AsyncWebSocketClient* client = socket->connect(&upgrade);
+    check(client != nullptr, "WebSocket client connects");
+    if (client) {
+      std::vector<String> connected = client->takeMessages();
+      check(connected.size() == 2, "WebSocket client receives its id and the current state");
+      DynamicJsonDocument state(DEFAULT_BUFFER_SIZE);
+      deserializeJson(state, connected.size() == 2 ? connected.back() : String());
+      uint32_t revision = state["revision"].as<uint32_t>();
+      socket->receive(client, "{\"type\":\"payload\",\"origin_id\":\"host\",\"payload\":{\"led_on\":false}}");
+      lightStateService.read([&](LightState& state) { ledOn = state.ledOn; });
+      check(!ledOn, "WebSocket message updates the state");
+      delay(PROPAGATION_INTERVAL);
+      LoopHook::loopAll();
+      std::vector<String> messages = client->takeMessages();
+      DynamicJsonDocument patch(DEFAULT_BUFFER_SIZE);
+      deserializeJson(patch, messages.size() == 1 ? messages.front() : String());
+      check(String(patch["type"] | "") == WEB_SOCKET_PATCH_TYPE,
+            "WebSocket clients are sent the changed fields as a patch");
+      check(patch["base"].as<uint32_t>() == revision,
+            "patch is based on the state the client was sent, though the state changed unbroadcast before");
+      socket->disconnect(client);
+    }
+  }
+  delay(PROPAGATION_INTERVAL);
+  LoopHook::loopAll();
+
+  // services are multiplexed over the WebSocket hub as channels
+  check(webSocketHub.addChannel("lightState",
+                                &lightStateService,
+                                LightState::read,
+                                LightState::update,
+                                AuthenticationPredicates::IS_AUTHENTICATED,
+                                LightStateFields::capacity()),
+        "light state is registered with the WebSocket hub");
+  if (AsyncWebSocket* hub = server.socket(WEB_SOCKET_HUB_PATH)) {
+    AsyncWebServerRequest upgrade(HTTP_GET, WEB_SOCKET_HUB_PATH);
+    upgrade.addParam(ACCESS_TOKEN_PARAMATER, jwt);
+    AsyncWebSocketClient* client = hub->connect(&upgrade);
+    check(client && client->takeMessages().size() == 1, "WebSocket hub client receives its id");
+    if (client) {
+      hub->receive(client, "{\"type\":\"subscribe\",\"channel\":\"unknown\"}");
+      std::vector<String> messages = client->takeMessages();
+      check(messages.size() == 1 && messages.front().indexOf("\"type\":\"error\"") >= 0,
+            "subscribing to an unknown channel is an error");
+      hub->receive(client, "{\"type\":\"subscribe\",\"channel\":\"lightState\"}");
+      messages = client->takeMessages();
+      check(messages.size() == 1 && messages.front().indexOf("\"channel\":\"lightState\"") >= 0 &&
+                messages.front().indexOf("\"led_on\":false") >= 0 && webSocketHub.getSubscribers("lightState") == 1,
+            "subscribing sends the channel's state");
+      hub->receive(client, "{\"type\":\"payload\",\"channel\":\"lightState\",\"payload\":{\"led_on\":true}}");
+      lightStateService.read([&](LightState& state) { ledOn = state.ledOn; });
+      check(ledOn, "hub payload updates the channel's service");
+      delay(PROPAGATION_INTERVAL);
+      LoopHook::loopAll();
+      messages = client->takeMessages();
+      check(messages.size() == 1 &&
+                messages.front().indexOf(String("\"origin_id\":\"") + WEB_SOCKET_ORIGIN_CLIENT_ID_PREFIX) >= 0,
+            "subscribers are sent changes tagged with their channel and origin");
+      for (int i = 0; i < WEB_SOCKET_QUEUE_BUDGET + 2; i++) {
+        lightStateService.update(
+            [](LightState& state) {
+              state.ledOn = !state.ledOn;
+              return StateUpdateResult::CHANGED;
+            },
+            "host");
+        delay(PROPAGATION_INTERVAL);
+        LoopHook::loopAll();
+      }
+      check(client->queueLength() == WEB_SOCKET_QUEUE_BUDGET,
+            "hub broadcasts to a subscriber over its budget are held");
+      client->takeMessages();
+      LoopHook::loopAll();
+      messages = client->takeMessages();
+      lightStateService.read([&](LightState& state) { ledOn = state.ledOn; });
+      check(messages.size() == 1 && messages.front().indexOf("\"channel\":\"lightState\"") >= 0 &&
+                messages.front().indexOf(ledOn ? "\"led_on\":true" : "\"led_on\":false") >= 0,
+            "a subscriber which has caught up is sent the latest state of the channels it missed");
+      hub->receive(client, "{\"type\":\"unsubscribe\",\"channel\":\"lightState\"}");
+      lightStateService.update(
+          [](LightState& state) {
+            state.ledOn = false;
+            return StateUpdateResult::CHANGED;
+          },
+          "host");
+      delay(PROPAGATION_INTERVAL);
+      LoopHook::loopAll();
+      check(client->takeMessages().empty() && webSocketHub.getSubscribers("lightState") == 0,
+            "unsubscribed clients are not sent changes");
+      hub->disconnect(client);
+    }
+  }
+  ledOn = false;
+
+  // WebSocket broadcasts may be sent as merge patches against the previous broadcast
+  {
+    StatefulService<LightMqttSettings> settings;
+    WebSocketTxRx<LightMqttSettings> deltaSocket(
+        LightMqttSettingsFields::read, LightMqttSettingsFields::update, &settings, &server, HOST_DELTA_SOCKET_PATH);
+    deltaSocket.enableDeltas();
+    AsyncWebSocket* socket = server.socket(HOST_DELTA_SOCKET_PATH);
+    AsyncWebSocketClient* client = socket ? socket->connect(nullptr) : nullptr;
+    check(client && client->takeMessages().size() == 2, "delta WebSocket client receives its id and the state");
+    if (client) {
+      auto rename = [&](const char* name) {
+        settings.update(
+            [&](LightMqttSettings& state) {
+              state.name = name;
+              return StateUpdateResult::CHANGED;
+            },
+            "host");
+        delay(PROPAGATION_INTERVAL);
+        LoopHook::loopAll();
+        std::vector<String> messages = client->takeMessages();
+        DynamicJsonDocument message(DEFAULT_BUFFER_SIZE);
+        deserializeJson(message, messages.size() == 1 ? messages.front() : String());
+        return message;
+      };
+      DynamicJsonDocument first = rename("first");
+      uint32_t revision = first["revision"];
+      check(String(first["type"] | "") == WEB_SOCKET_PAYLOAD_TYPE && revision == settings.getRevision(),
+            "first broadcast sends the full state with its revision");
+      DynamicJsonDocument second = rename("second");
+      check(String(second["type"] | "") == WEB_SOCKET_PATCH_TYPE && second["base"].as<uint32_t>() == revision &&
+                second["payload"].size() == 1 && String(second["payload"]["name"] | "") == "second",
+            "later broadcasts send a merge patch of the changes based on the previous revision");
+      socket->receive(client, "{\"type\":\"resync\"}");
+      std::vector<String> messages = client->takeMessages();
+      String name;
+      settings.read([&](LightMqttSettings& state) { name = state.name; });
+      check(messages.size() == 1 && messages.front().indexOf("\"type\":\"payload\"") >= 0 && name == "second",
+            "resync sends the full state without updating it");
+      socket->disconnect(client);
+    }
+    server.removeHandler(socket);
+  }
+
+  // a client which falls behind is sent the latest state once it catches up, rather than every state it missed
+  {
+    StatefulService<LightMqttSettings> settings;
+    WebSocketTx<LightMqttSettings> slowSocket(LightMqttSettingsFields::read, &settings, &server, HOST_SLOW_SOCKET_PATH);
+    AsyncWebSocket* socket = server.socket(HOST_SLOW_SOCKET_PATH);
+    AsyncWebSocketClient* client = socket ? socket->connect(nullptr) : nullptr;
+    if (client) {
+      client->takeMessages();
+      for (int i = 0; i < WEB_SOCKET_QUEUE_BUDGET + 2; i++) {
+        settings.update(
+            [&](LightMqttSettings& state) {
+              state.name = String("name") + i;
+              return StateUpdateResult::CHANGED;
+            },
+            "host");
+        delay(PROPAGATION_INTERVAL);
+        LoopHook::loopAll();
+      }
+      check(client->queueLength() == WEB_SOCKET_QUEUE_BUDGET && client->droppedMessages() == 0,
+            "broadcasts to a client over its queue budget are held back");
+      AsyncWebServerRequest request(HTTP_GET, WEB_SOCKET_STATS_SERVICE_PATH);
+      AsyncWebServerResponse* response = serve(server, request, jwt);
+      DynamicJsonDocument stats(DEFAULT_BUFFER_SIZE);
+      deserializeJson(stats, response ? response->content() : String());
+      JsonObject slow;
+      for (JsonObject entry : stats["sockets"].as<JsonArray>()) {
+        if (String(entry["path"] | "") == HOST_SLOW_SOCKET_PATH) {
+          slow = entry["clients"][0];
+        }
+      }
+      check(slow["queued"].as<int>() == WEB_SOCKET_QUEUE_BUDGET && slow["dropped"].as<int>() == 2 &&
+                slow["stale"].as<bool>(),
+            "WebSocket stats report each client's queue depth and dropped broadcasts");
+      client->takeMessages();
+      LoopHook::loopAll();
+      std::vector<String> messages = client->takeMessages();
+      String latest = String("\"name\":\"name") + (WEB_SOCKET_QUEUE_BUDGET + 1) + "\"";
+      check(messages.size() == 1 && messages.front().indexOf(latest) >= 0,
+            "a client which has caught up is sent the latest state once");
+      socket->disconnect(client);
+    }
+    server.removeHandler(socket);
+  }
+
+  // a full update handler table refuses further handlers, which are counted for the system status
+  {
+    const uint8_t capacity = StateTraits<LightState>::updateHandlerCapacity;
+    uint16_t refused = StateUpdateHandlerInfo_t::refusedCount;
+    update_handler_id_t ids[capacity];
+    uint8_t added = 0;
+    while (added < capacity &&
+           (ids[added] = lightStateService.addUpdateHandler(
+                [](void* context, const String& originId, state_field_mask_t changedFields) {}, nullptr))) {
+      added++;
+    }
+    check(added < capacity && StateUpdateHandlerInfo_t::refusedCount == refused + 1,
+          "update handler refused by a full table is counted");
+    for (uint8_t i = 0; i < added; i++) {
+      lightStateService.removeUpdateHandler(ids[i]);
+    }
+  }
+
+  // MQTT
+  mqttClient.connect();
+  check(mqttClient.subscriptions().size() == 1, "MQTT state topic is subscribed on connect");
+  if (mqttClient.subscriptions().size() == 1) {
+    String topic = mqttClient.subscriptions().front();
+    mqttClient.publications().clear();
+    mqttClient.receive(topic, "{\"state\":\"ON\"}");
+    mqttClient.receive(topic, "{\"state\":\"OFF\"}");
+    mqttClient.receive(topic, "{\"state\":\"ON\"}");
+    lightStateService.read([&](LightState& state) { ledOn = state.ledOn; });
+    check(ledOn, "MQTT message updates the state");
+    check(mqttClient.publications().empty(), "propagation is deferred to the loop");
+    delay(PROPAGATION_INTERVAL);
+    LoopHook::loopAll();
+    check(mqttClient.publications().size() == 1, "burst of updates is propagated once");
+  }
+
+  // FS, the POST endpoint propagates from the loop once the request is disconnected
+  {
+    AsyncWebServerRequest request(HTTP_POST, LIGHT_BROKER_SETTINGS_PATH, "{\"mqtt_path\":\"host/light\"}");
+    serve(server, request, jwt);
+    LoopHook::loopAll();
+    check(readPersisted(LIGHT_BROKER_SETTINGS_FILE, "mqtt_path") != "host/light",
+          "propagation is held while the request is connected");
+  }
+  LoopHook::loopAll();
+  check(readPersisted(LIGHT_BROKER_SETTINGS_FILE, "mqtt_path") == "host/light",
+        "settings update is persisted to the filesystem");
+  {
+    uint32_t propagated = PropagationQueue::getPropagated();
+    AsyncWebServerRequest request(
+        HTTP_POST, LIGHT_BROKER_SETTINGS_PATH, "{\"mqtt_path\":\"host/light\",\"name\":\"held\"}");
+    serve(server, request, jwt);
+    delay(PROPAGATION_QUEUE_DEADLINE);
+    LoopHook::loopAll();
+    check(readPersisted(LIGHT_BROKER_SETTINGS_FILE, "name") == "held" &&
+              PropagationQueue::getPropagated() == propagated + 1,
+          "propagation runs at its deadline if the request stays connected");
+    check(PropagationQueue::getMaxLatency() >= PROPAGATION_QUEUE_DEADLINE, "propagation latency is recorded");
+  }
+
+  // PATCH merges the given fields into the state, null resets a field to its default
+  {
+    AsyncWebServerRequest request(HTTP_PATCH, LIGHT_BROKER_SETTINGS_PATH, "{\"name\":\"patched\"}");
+    AsyncWebServerResponse* response = serve(server, request, jwt);
+    check(response && response->code() == 200, "PATCH is accepted");
+  }
+  LoopHook::loopAll();
+  check(readPersisted(LIGHT_BROKER_SETTINGS_FILE, "name") == "patched", "PATCH updates the given field");
+  check(readPersisted(LIGHT_BROKER_SETTINGS_FILE, "mqtt_path") == "host/light", "PATCH leaves other fields intact");
+  {
+    AsyncWebServerRequest request(HTTP_PATCH, LIGHT_BROKER_SETTINGS_PATH, "{\"name\":null}");
+    serve(server, request, jwt);
+  }
+  LoopHook::loopAll();
+  check(readPersisted(LIGHT_BROKER_SETTINGS_FILE, "name") != "patched", "PATCH with null resets the field");
+  {
+    AsyncWebServerRequest request(HTTP_PATCH, LIGHT_BROKER_SETTINGS_PATH, "[1]");
+    AsyncWebServerResponse* response = serve(server, request, jwt);
+    check(response && response->code() == 400, "PATCH which is not an object is rejected");
+  }
+
+  // batch reads and all-or-nothing batch writes
+  {
+    batchEndpoint.addService("lightState", &lightStateService, LightState::read, LightState::update);
+    batchEndpoint.addService(
+        "brokerSettings", &lightMqttSettingsService, LightMqttSettingsFields::read, LightMqttSettingsFields::update);
+    batchEndpoint.addReader(
+        "hostStatus", [](void* context, JsonObject& root) { root["uptime"] = millis(); }, nullptr, JSON_OBJECT_SIZE(1));
+    {
+      AsyncWebServerRequest request(HTTP_GET, BATCH_ENDPOINT_PATH);
+      server.handleRequest(&request);
+      check(request.response() && request.response()->code() == 401, "unauthenticated batch read is rejected");
+    }
+    {
+      AsyncWebServerRequest request(HTTP_GET, BATCH_ENDPOINT_PATH);
+      request.addParam(BATCH_ENDPOINT_INCLUDE_PARAMETER, "brokerSettings,hostStatus");
+      AsyncWebServerResponse* response = serve(server, request, jwt);
+      DynamicJsonDocument batch(DEFAULT_BUFFER_SIZE);
+      deserializeJson(batch, response ? response->content() : String());
+      check(batch.size() == 2 && String(batch["brokerSettings"]["mqtt_path"] | "") == "host/light" &&
+                batch["hostStatus"].containsKey("uptime"),
+            "batch read returns the included sources");
+      check(AdmissionControl::getReserved() == DEFAULT_BUFFER_SIZE,
+            "batch read reserves the largest source rather than every source");
+    }
+    bool ledOn = false;
+    lightStateService.read([&](LightState& state) { ledOn = state.ledOn; });
+    String tooLong;
+    for (size_t i = 0; i <= LIGHT_MQTT_PATH_MAX_LENGTH; i++) {
+      tooLong += 'x';
+    }
+    {
+      AsyncWebServerRequest request(HTTP_POST,
+                                    BATCH_ENDPOINT_PATH,
+                                    String("{\"lightState\":{\"led_on\":") + (ledOn ? "false" : "true") +
+                                        "},\"brokerSettings\":{\"mqtt_path\":\"" + tooLong + "\"}}");
+      AsyncWebServerResponse* response = serve(server, request, jwt);
+      check(response && response->code() == 400, "batch write with a rejected state fails");
+    }
+    bool ledOnAfter = ledOn;
+    lightStateService.read([&](LightState& state) { ledOnAfter = state.ledOn; });
+    check(ledOnAfter == ledOn, "failed batch write changes no service");
+    {
+      AsyncWebServerRequest request(HTTP_POST,
+                                    BATCH_ENDPOINT_PATH,
+                                    String("{\"lightState\":{\"led_on\":") + (ledOn ? "false" : "true") +
+                                        "},\"brokerSettings\":{\"mqtt_path\":\"host/light\",\"name\":\"batched\"}}");
+      AsyncWebServerResponse* response = serve(server, request, jwt);
+      check(response && response->code() == 200, "batch write succeeds");
+      check(AdmissionControl::getReserved() == BATCH_ENDPOINT_MAX_CONTENT_LENGTH,
+            "batch write reserves its body document as well as its largest source");
+    }
+    LoopHook::loopAll();
+    lightStateService.read([&](LightState& state) { ledOnAfter = state.ledOn; });
+    check(ledOnAfter != ledOn && readPersisted(LIGHT_BROKER_SETTINGS_FILE, "name") == "batched",
+          "batch write updates and propagates every service");
+
+    // accepts the copy it is checked against and rejects the write, as if updated by another task in between
+    StatefulService<LightState> contended;
+    batchEndpoint.addService("contended", &contended, LightState::read, [](JsonObject& root, LightState& state) {
+      static bool checked = false;
+      checked = !checked;
+      return checked ? StateUpdateResult::UNCHANGED : StateUpdateResult::ERROR;
+    });
+    {
+      AsyncWebServerRequest request(HTTP_POST,
+                                    BATCH_ENDPOINT_PATH,
+                                    String("{\"lightState\":{\"led_on\":") + (ledOn ? "true" : "false") +
+                                        "},\"contended\":{}}");
+      AsyncWebServerResponse* response = serve(server, request, jwt);
+      DynamicJsonDocument batch(DEFAULT_BUFFER_SIZE);
+      deserializeJson(batch, response ? response->content() : String());
+      check(response && response->code() == 409 && batch.size() == 2,
+            "batch write rejected after its check answers 409 with the services' state");
+    }
+    LoopHook::loopAll();
+    lightStateService.read([&](LightState& state) { ledOnAfter = state.ledOn; });
+    check(ledOnAfter == ledOn, "batch write rejected after its check still writes the other services");
+  }
+
+  // large states are serialized straight into the response rather than into a string
+  {
+    StatefulService<LightMqttSettings> settings;
+    HttpGetEndpoint<LightMqttSettings> endpoint(
+        LightMqttSettingsFields::read, &settings, &server, HOST_STREAMED_PATH, HOST_STREAMED_BUFFER_SIZE);
+    settings.update(
+        [&](LightMqttSettings& state) {
+          state.name = String();
+          for (size_t i = 0; i < HOST_STREAMED_NAME_LENGTH; i++) {
+            state.name += 'x';
+          }
+          return StateUpdateResult::CHANGED;
+        },
+        "host");
+    AsyncWebServerRequest request(HTTP_GET, HOST_STREAMED_PATH);
+    server.handleRequest(&request);
+    AsyncWebServerResponse* response = request.response();
+    DynamicJsonDocument jsonDocument(HOST_STREAMED_BUFFER_SIZE);
+    String content = response ? response->content() : String();
+    check(deserializeJson(jsonDocument, content) == DeserializationError::Ok &&
+              String(jsonDocument["name"] | "").length() == HOST_STREAMED_NAME_LENGTH,
+          "large GET returns the whole state");
+    check(response && response->contentLength() == content.length(), "large GET is sent with its length");
+  }
+
+  // documents are written a chunk at a time, resuming within values which straddle a chunk boundary
+  {
+    DynamicJsonDocument jsonDocument(1024);
+    deserializeJson(jsonDocument,
+                    "{\"name\":\"a \\\"quoted\\\" name\",\"empty\":{},\"list\":[1,[],{\"on\":true}],"
+                    "\"nested\":{\"depth\":{\"value\":-2.5,\"none\":null}}}");
+    String expected;
+    serializeJson(jsonDocument, expected);
+    bool matches = true;
+    for (size_t chunkSize = 1; chunkSize <= 8; chunkSize++) {
+      ChunkedJsonWriter writer;
+      writer.begin(&jsonDocument);
+      String written;
+      uint8_t buffer[8];
+      for (size_t len = writer.write(buffer, chunkSize); len; len = writer.write(buffer, chunkSize)) {
+        written.concat((const char*)buffer, len);
+      }
+      matches = matches && writer.done() && written == expected;
+    }
+    check(matches, "chunked writer matches serializeJson for every chunk size");
+  }
+
+  // requests are shed while the heap is low, unless they control the device
+  {
+    ESP.setHeap(ADMISSION_CONTROL_NORMAL_WATERMARK, ADMISSION_CONTROL_NORMAL_WATERMARK);
+    uint32_t shed = AdmissionControl::getShed(RequestPriority::NORMAL);
+    {
+      AsyncWebServerRequest request(HTTP_GET, LIGHT_BROKER_SETTINGS_PATH);
+      AsyncWebServerResponse* response = serve(server, request, jwt);
+      check(response && response->code() == 503 && response->header("Retry-After"),
+            "settings GET is shed with Retry-After while the heap is low");
+    }
+    check(AdmissionControl::getShed(RequestPriority::NORMAL) == shed + 1, "shed request is counted");
+    bool ledOn = false;
+    lightStateService.read([&](LightState& state) { ledOn = state.ledOn; });
+    {
+      AsyncWebServerRequest request(
+          HTTP_POST, LIGHT_SETTINGS_ENDPOINT_PATH, String("{\"led_on\":") + (ledOn ? "true" : "false") + "}");
+      AsyncWebServerResponse* response = serve(server, request, jwt);
+      check(response && response->code() == 200, "light POST is admitted while the heap is low");
+    }
+    ESP.setHeap(40 * 1024, 32 * 1024);
+    {
+      AsyncWebServerRequest request(HTTP_GET, LIGHT_BROKER_SETTINGS_PATH);
+      AsyncWebServerResponse* response = serve(server, request, jwt);
+      check(response && response->code() == 200 && AdmissionControl::getReserved() > 0,
+            "requests are admitted once the heap recovers and hold their reservation until they disconnect");
+    }
+    check(AdmissionControl::getReserved() == 0, "disconnected requests release their reservation");
+  }
+
+  // disconnect callbacks registered under a hold run once the reservation is released
+  {
+    bool released = false;
+    {
+      AsyncWebServerRequest request(HTTP_POST, LIGHT_SETTINGS_ENDPOINT_PATH);
+      AdmissionControl::admit(RequestPriority::NORMAL, JSON_OBJECT_SIZE(1));
+      AdmissionControl::hold(&request, JSON_OBJECT_SIZE(1));
+      AdmissionControl::admit(RequestPriority::NORMAL, JSON_OBJECT_SIZE(2));
+      check(AdmissionControl::hold(&request, JSON_OBJECT_SIZE(2)), "request may be held again");
+      AdmissionControl::onDisconnect(&request, [&]() { released = AdmissionControl::getReserved() == 0; });
+    }
+    check(released, "request held twice releases both reservations before its disconnect callback");
+  }
+
+  // FS write-behind
+  {
+    StatefulService<LightMqttSettings> settings;
+    FSPersistence<LightMqttSettings> persistence(
+        LightMqttSettingsFields::read, LightMqttSettingsFields::update, &settings, &ESPFS, HOST_WRITE_BEHIND_FILE);
+    persistence.readFromFS();
+    persistence.writeBehind(HOST_WRITE_BEHIND_QUIET_PERIOD, HOST_WRITE_BEHIND_MAX_DELAY);
+    for (const char* name : {"a", "b", "c"}) {
+      settings.update(
+          [&](LightMqttSettings& state) {
+            state.name = name;
+            return StateUpdateResult::CHANGED;
+          },
+          "host");
+    }
+    check(readPersisted(HOST_WRITE_BEHIND_FILE, "name") == "", "write-behind defers the write");
+    delay(HOST_WRITE_BEHIND_QUIET_PERIOD);
+    LoopHook::loopAll();
+    check(readPersisted(HOST_WRITE_BEHIND_FILE, "name") == "c", "write-behind writes once the changes are quiet");
+    settings.update(
+        [&](LightMqttSettings& state) {
+          state.name = "d";
+          return StateUpdateResult::CHANGED;
+        },
+        "host");
+    WriteBehind::flushAll();
+    check(readPersisted(HOST_WRITE_BEHIND_FILE, "name") == "d", "pending writes are flushed");
+    check(persistence.writeToFS(), "unchanged state is not rewritten");
+    AsyncWebServerRequest request(HTTP_GET, PERSISTENCE_STATS_SERVICE_PATH);
+    AsyncWebServerResponse* response = serve(server, request, jwt);
+    DynamicJsonDocument stats(DEFAULT_BUFFER_SIZE);
+    deserializeJson(stats, response ? response->content() : String());
+    JsonObject file = stats["files"][0];
+    check(String(file["path"] | "") == HOST_WRITE_BEHIND_FILE && file["writes"].as<int>() == 2 &&
+          file["skipped"].as<int>() == 1,
+          "persistence stats count the writes issued and skipped");
+  }
+
+#if FS_PERSISTENCE_CONFIG_STORE
+  // config store
+  {
+    ConfigStore store(&ESPFS, HOST_CONFIG_STORE_FILE);
+    DynamicJsonDocument jsonDocument(DEFAULT_BUFFER_SIZE);
+    JsonFileFormat format;
+    for (const char* name : {"a", "b"}) {
+      jsonDocument["name"] = name;
+      store.write("key", jsonDocument, FS_PERSISTENCE_FORMAT);
+    }
+    // a record cut short after its header
+    File log = ESPFS.open(HOST_CONFIG_STORE_FILE, "a");
+    log.write((const uint8_t*)"\xc5\x03\x10\x00key", 7);
+    log.close();
+
+    ConfigStore reopened(&ESPFS, HOST_CONFIG_STORE_FILE);
+    check(reopened.read("key", jsonDocument, format) && String(jsonDocument["name"] | "") == "b",
+          "torn record leaves the previous record current");
+    jsonDocument["name"] = "c";
+    reopened.write("key", jsonDocument, FS_PERSISTENCE_FORMAT);
+    ConfigStore appended(&ESPFS, HOST_CONFIG_STORE_FILE);
+    check(appended.read("key", jsonDocument, format) && String(jsonDocument["name"] | "") == "c",
+          "damaged tail is dropped before appending");
+    check(appended.size() > appended.liveSize() && appended.compact() && appended.size() == appended.liveSize(),
+          "compaction drops superseded records");
+    ConfigStore compacted(&ESPFS, HOST_CONFIG_STORE_FILE);
+    check(compacted.read("key", jsonDocument, format) && String(jsonDocument["name"] | "") == "c",
+          "compacted log holds the current records");
+  }
+
+  // FS files written before the config store was in use
+  {
+    File legacy = ESPFS.open(HOST_MIGRATED_FILE, "w");
+    legacy.print("{\"name\":\"legacy\"}");
+    legacy.close();
+    StatefulService<LightMqttSettings> settings;
+    FSPersistence<LightMqttSettings> persistence(
+        LightMqttSettingsFields::read, LightMqttSettingsFields::update, &settings, &ESPFS, HOST_MIGRATED_FILE);
+    persistence.readFromFS();
+    String name;
+    settings.read([&](LightMqttSettings& state) { name = state.name; });
+    check(name == "legacy" && readPersisted(HOST_MIGRATED_FILE, "name") == "legacy",
+          "file is moved into the config store");
+    check(!ESPFS.exists(HOST_MIGRATED_FILE), "file is removed once moved into the config store");
+  }
+#else
+  // FS checksums, the previous write of the file above is kept as a backup
+  {
+    File written = ESPFS.open(HOST_WRITE_BEHIND_FILE, "r");
+    check(written && ChecksumFile::verify(written), "persisted file carries a checksum trailer");
+    written.close();
+    written = ESPFS.open(HOST_WRITE_BEHIND_FILE, "r+");
+    written.seek(0);
+    written.write('[');
+    written.close();
+    StatefulService<LightMqttSettings> settings;
+    FSPersistence<LightMqttSettings> persistence(
+        LightMqttSettingsFields::read, LightMqttSettingsFields::update, &settings, &ESPFS, HOST_WRITE_BEHIND_FILE);
+    persistence.readFromFS();
+    String name;
+    settings.read([&](LightMqttSettings& state) { name = state.name; });
+    check(name == "c", "corrupt file is rolled back to the backup");
+
+    File legacy = ESPFS.open(HOST_WRITE_BEHIND_FILE, "w");
+    legacy.print("{\"name\":\"legacy\"}");
+    legacy.close();
+    persistence.readFromFS();
+    settings.read([&](LightMqttSettings& state) { name = state.name; });
+    check(name == "legacy", "file without a checksum trailer is loaded");
+    JsonFileFormat format = JsonFileFormat::JSON;
+    check(readPersisted(HOST_WRITE_BEHIND_FILE, "name", &format) == "legacy" && format == FS_PERSISTENCE_FORMAT,
+          "file in the other format is rewritten in the configured format");
+  }
+#endif
+
+  // stored strings longer than the current limit, the last character straddles it
+  {
+    String overlong;
+    for (int i = 0; i < LIGHT_NAME_MAX_LENGTH - 1; i++) {
+      overlong += 'a';
+    }
+    File legacy = ESPFS.open(HOST_OVERLONG_FILE, "w");
+    legacy.print("{\"mqtt_path\":\"legacy/path\",\"name\":\"" + overlong + "\xc3\xa9\"}");
+    legacy.close();
+    StatefulService<LightMqttSettings> settings;
+    FSPersistence<LightMqttSettings> persistence(
+        LightMqttSettingsFields::read, LightMqttSettingsFields::load, &settings, &ESPFS, HOST_OVERLONG_FILE);
+    persistence.readFromFS();
+    String name, mqttPath;
+    settings.read([&](LightMqttSettings& state) {
+      name = state.name;
+      mqttPath = state.mqttPath;
+    });
+    check(name == overlong, "over-long stored string is cut at a character boundary");
+    check(mqttPath == "legacy/path", "state with an over-long stored string keeps its other fields");
+  }
+
+  // a handler replacing a hold's disconnect handler would leave its reservation behind
+  check(AdmissionControl::getReserved() == 0, "every reservation is released once its request disconnects");
+
+  printf("%d failure(s)\n", failures);
+  return failures ? 1 : 0;
+}
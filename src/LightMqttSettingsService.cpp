@@ -1,14 +1,20 @@
 #include <LightMqttSettingsService.h>
 
 LightMqttSettingsService::LightMqttSettingsService(AsyncWebServer* server, FS* fs, SecurityManager* securityManager) :
-    _httpEndpoint(LightMqttSettings::read,
-                  LightMqttSettings::update,
+    _httpEndpoint(LightMqttSettingsFields::read,
+                  LightMqttSettingsFields::update,
                   this,
                   server,
                   LIGHT_BROKER_SETTINGS_PATH,
                   securityManager,
-                  AuthenticationPredicates::IS_AUTHENTICATED),
-    _fsPersistence(LightMqttSettings::read, LightMqttSettings::update, this, fs, LIGHT_BROKER_SETTINGS_FILE) {
+                  AuthenticationPredicates::IS_AUTHENTICATED,
+                  LightMqttSettingsFields::capacity()),
+    _fsPersistence(LightMqttSettingsFields::read,
+                   LightMqttSettingsFields::load,
+                   this,
+                   fs,
+                   LIGHT_BROKER_SETTINGS_FILE,
+                   LightMqttSettingsFields::capacity()) {
 }
 
 void LightMqttSettingsService::begin() {
@@ -3,31 +3,42 @@
 
 #include <HttpEndpoint.h>
 #include <FSPersistence.h>
+#include <JsonStateFields.h>
 #include <ESPUtils.h>
 
 #define LIGHT_BROKER_SETTINGS_FILE "/config/brokerSettings.json"
 #define LIGHT_BROKER_SETTINGS_PATH "/rest/brokerSettings"
+#define LIGHT_MQTT_PATH_MAX_LENGTH 128
+#define LIGHT_NAME_MAX_LENGTH 64
 
 class LightMqttSettings {
  public:
   String mqttPath;
   String name;
   String uniqueId;
-
-  static void read(LightMqttSettings& settings, JsonObject& root) {
-    root["mqtt_path"] = settings.mqttPath;
-    root["name"] = settings.name;
-    root["unique_id"] = settings.uniqueId;
-  }
-
-  static StateUpdateResult update(JsonObject& root, LightMqttSettings& settings) {
-    settings.mqttPath = root["mqtt_path"] | ESPUtils::defaultDeviceValue("homeassistant/light/");
-    settings.name = root["name"] | ESPUtils::defaultDeviceValue("light-");
-    settings.uniqueId = root["unique_id"] | ESPUtils::defaultDeviceValue("light-");
-    return StateUpdateResult::CHANGED;
-  }
 };
 
+JSON_STATE_STRING_FIELD(LightMqttPathField,
+                        LightMqttSettings,
+                        mqttPath,
+                        "mqtt_path",
+                        ESPUtils::defaultDeviceValue("homeassistant/light/"),
+                        LIGHT_MQTT_PATH_MAX_LENGTH);
+JSON_STATE_STRING_FIELD(LightNameField,
+                        LightMqttSettings,
+                        name,
+                        "name",
+                        ESPUtils::defaultDeviceValue("light-"),
+                        LIGHT_NAME_MAX_LENGTH);
+JSON_STATE_STRING_FIELD(LightUniqueIdField,
+                        LightMqttSettings,
+                        uniqueId,
+                        "unique_id",
+                        ESPUtils::defaultDeviceValue("light-"),
+                        LIGHT_NAME_MAX_LENGTH);
+typedef JsonStateFields<LightMqttSettings, LightMqttPathField, LightNameField, LightUniqueIdField>
+    LightMqttSettingsFields;
+
 class LightMqttSettingsService : public StatefulService<LightMqttSettings> {
  public:
   LightMqttSettingsService(AsyncWebServer* server, FS* fs, SecurityManager* securityManager);
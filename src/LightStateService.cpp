@@ -1,4 +1,45 @@
 #include <LightStateService.h>
+#include <WebSocketHub.h>
+
+// the service's own handler, MqttPub, WebSocketTx and the lightState channel src/main.cpp adds to the WebSocketHub
+static_assert(1 + MqttPubSub<LightState>::updateHandlerCount + WebSocketTxRx<LightState>::updateHandlerCount +
+                      WebSocketHub::updateHandlersPerChannel <=
+                  StateTraits<LightState>::updateHandlerCapacity,
+              "LightState's update handler table is too small for the handlers registered at boot");
+
+void LightState::read(LightState& settings, JsonObject& root) {
+  LightStateFields::read(settings, root);
+}
+
+void LightState::readFields(LightState& settings, JsonObject& root, state_field_mask_t fields) {
+  LightStateFields::readFields(settings, root, fields);
+}
+
+StateUpdateResult LightState::update(JsonObject& root, LightState& lightState) {
+  return LightStateFields::update(root, lightState);
+}
+
+void LightState::haRead(LightState& settings, JsonObject& root) {
+  root["state"] = settings.ledOn ? ON_STATE : OFF_STATE;
+}
+
+StateUpdateResult LightState::haUpdate(JsonObject& root, LightState& lightState) {
+  String state = root["state"];
+  // parse new led state
+  boolean newState = false;
+  if (state.equals(ON_STATE)) {
+    newState = true;
+  } else if (!state.equals(OFF_STATE)) {
+    return StateUpdateResult::ERROR;
+  }
+  // change the new state, if required
+  if (lightState.ledOn != newState) {
+    lightState.ledOn = newState;
+    lightState.markChanged(LightStateFields::field<LightStateLedOnField>());
+    return StateUpdateResult::CHANGED;
+  }
+  return StateUpdateResult::UNCHANGED;
+}
 
 LightStateService::LightStateService(AsyncWebServer* server,
                                      SecurityManager* securityManager,
@@ -10,7 +51,15 @@ LightStateService::LightStateService(AsyncWebServer* server,
                   server,
                   LIGHT_SETTINGS_ENDPOINT_PATH,
                   securityManager,
-                  AuthenticationPredicates::IS_AUTHENTICATED),
+                  AuthenticationPredicates::IS_AUTHENTICATED,
+                  LightStateFields::capacity()),
+    _longPollEndpoint(LightState::read,
+                      this,
+                      server,
+                      LIGHT_SETTINGS_POLL_PATH,
+                      securityManager,
+                      AuthenticationPredicates::IS_AUTHENTICATED,
+                      LightStateFields::capacity()),
     _mqttPubSub(LightState::haRead, LightState::haUpdate, this, mqttClient),
     _webSocket(LightState::read,
                LightState::update,
@@ -28,14 +77,37 @@ LightStateService::LightStateService(AsyncWebServer* server,
   _mqttClient->onConnect(std::bind(&LightStateService::registerConfig, this));
 
   // configure update handler for when the light settings change
-  _lightMqttSettingsService->addUpdateHandler([&](const String& originId) { registerConfig(); }, false);
+  _lightMqttSettingsService->addUpdateHandler(
+      [](void* context, const String& originId, state_field_mask_t changedFields) {
+        static_cast<LightStateService*>(context)->registerConfig();
+      },
+      this,
+      false);
 
   // configure settings service update handler to update LED state
-  addUpdateHandler([&](const String& originId) { onConfigUpdated(); }, false);
+  addUpdateHandler(
+      [](void* context, const String& originId, state_field_mask_t changedFields) {
+        static_cast<LightStateService*>(context)->onConfigUpdated();
+      },
+      this,
+      false);
+
+  // send websocket clients only the fields which changed
+  _webSocket.setFieldReader(LightState::readFields);
+
+  // switching the light must work even when the heap is too low to serve status pages
+  _httpEndpoint.setPriority(RequestPriority::CONTROL);
+  _webSocket.setPriority(RequestPriority::CONTROL);
+
+  // collapse bursts of updates, such as rapid toggling in the UI, into a single propagation from the loop
+  deferPropagation(PROPAGATION_INTERVAL);
 }
 
 void LightStateService::begin() {
-  _state.ledOn = DEFAULT_LED_STATE;
+  updateWithoutPropagation([&](LightState& state) {
+    state.ledOn = DEFAULT_LED_STATE;
+    return StateUpdateResult::CHANGED;
+  });
   onConfigUpdated();
 }
 
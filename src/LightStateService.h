@@ -4,11 +4,14 @@
 #include <LightMqttSettingsService.h>
 
 #include <HttpEndpoint.h>
+#include <JsonStateFields.h>
+#include <LongPollEndpoint.h>
 #include <MqttPubSub.h>
 #include <WebSocketTxRx.h>
 
 #define LED_PIN 2
 #define PRINT_DELAY 5000
+#define PROPAGATION_INTERVAL 50
 
 #define DEFAULT_LED_STATE false
 #define OFF_STATE "OFF"
@@ -26,44 +29,33 @@
 
 #define LIGHT_SETTINGS_ENDPOINT_PATH "/rest/lightState"
 #define LIGHT_SETTINGS_SOCKET_PATH "/ws/lightState"
+#define LIGHT_SETTINGS_POLL_PATH "/rest/poll/lightState"
 
-class LightState {
+class LightState : public TrackedState {
  public:
   bool ledOn;
 
-  static void read(LightState& settings, JsonObject& root) {
-    root["led_on"] = settings.ledOn;
-  }
+  // generated from the field descriptors below
+  static void read(LightState& settings, JsonObject& root);
+  static void readFields(LightState& settings, JsonObject& root, state_field_mask_t fields);
+  static StateUpdateResult update(JsonObject& root, LightState& lightState);
 
-  static StateUpdateResult update(JsonObject& root, LightState& lightState) {
-    boolean newState = root["led_on"] | DEFAULT_LED_STATE;
-    if (lightState.ledOn != newState) {
-      lightState.ledOn = newState;
-      return StateUpdateResult::CHANGED;
-    }
-    return StateUpdateResult::UNCHANGED;
-  }
+  // Home Assistant's JSON schema is served over MQTT
+  static void haRead(LightState& settings, JsonObject& root);
+  static StateUpdateResult haUpdate(JsonObject& root, LightState& lightState);
+};
 
-  static void haRead(LightState& settings, JsonObject& root) {
-    root["state"] = settings.ledOn ? ON_STATE : OFF_STATE;
-  }
+JSON_STATE_FIELD(LightStateLedOnField, LightState, ledOn, "led_on", DEFAULT_LED_STATE);
+typedef JsonStateFields<LightState, LightStateLedOnField> LightStateFields;
 
-  static StateUpdateResult haUpdate(JsonObject& root, LightState& lightState) {
-    String state = root["state"];
-    // parse new led state 
-    boolean newState = false;
-    if (state.equals(ON_STATE)) {
-      newState = true;
-    } else if (!state.equals(OFF_STATE)) {
-      return StateUpdateResult::ERROR;
-    }
-    // change the new state, if required
-    if (lightState.ledOn != newState) {
-      lightState.ledOn = newState;
-      return StateUpdateResult::CHANGED;
-    }
-    return StateUpdateResult::UNCHANGED;
-  }
+// The light state is read far more often than it is written, serve reads from a snapshot and share the payloads
+// serialized by the REST/WebSocket and MQTT readers between the endpoints
+template <>
+struct StateTraits<LightState> : DefaultStateTraits {
+  static const bool snapshotReads = true;
+  static const uint8_t payloadCacheCapacity = 2;
+  // the service's own handler, MqttPub, WebSocketTx and the hub channel, with room for two more consumers
+  static const uint8_t updateHandlerCapacity = 6;
 };
 
 class LightStateService : public StatefulService<LightState> {
@@ -76,6 +68,7 @@ class LightStateService : public StatefulService<LightState> {
 
  private:
   HttpEndpoint<LightState> _httpEndpoint;
+  LongPollEndpoint<LightState> _longPollEndpoint;
   MqttPubSub<LightState> _mqttPubSub;
   WebSocketTxRx<LightState> _webSocket;
   AsyncMqttClient* _mqttClient;
@@ -6,12 +6,11 @@
 
 AsyncWebServer server(80);
 ESP8266React esp8266React(&server);
-LightMqttSettingsService lightMqttSettingsService =
-    LightMqttSettingsService(&server, esp8266React.getFS(), esp8266React.getSecurityManager());
-LightStateService lightStateService = LightStateService(&server,
-                                                        esp8266React.getSecurityManager(),
-                                                        esp8266React.getMqttClient(),
-                                                        &lightMqttSettingsService);
+LightMqttSettingsService lightMqttSettingsService(&server, esp8266React.getFS(), esp8266React.getSecurityManager());
+LightStateService lightStateService(&server,
+                                    esp8266React.getSecurityManager(),
+                                    esp8266React.getMqttClient(),
+                                    &lightMqttSettingsService);
 
 void setup() {
   // start serial and filesystem
@@ -21,13 +20,27 @@ void setup() {
   esp8266React.begin();
 
   // load the initial light settings
-  lightStateService.begin();
-
-  // start the light service
-  lightMqttSettingsService.begin();
+  BootProfile::measure("light_state", []() { lightStateService.begin(); });
+
+  // follow the light over the framework's WebSocket hub alongside any other channels
+  if (!esp8266React.getWebSocketHub()->addChannel("lightState",
+                                                 &lightStateService,
+                                                 LightState::read,
+                                                 LightState::update,
+                                                 AuthenticationPredicates::IS_AUTHENTICATED,
+                                                 LightStateFields::capacity())) {
+    Serial.println(F("No room for the lightState channel on the WebSocket hub"));
+  }
+
+  // the light's MQTT settings are not needed until MQTT connects
+  esp8266React.deferBegin(
+      "light_mqtt_settings",
+      [](void* context) { static_cast<LightMqttSettingsService*>(context)->begin(); },
+      &lightMqttSettingsService);
 
   // start the server
   server.begin();
+  BootProfile::mark("server_started");
 }
 
 void loop() {